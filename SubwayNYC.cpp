@@ -1,215 +1,1276 @@
-#include <bits.stdc++.h>
-
-using namespace std;
-
-// ANSI color codes for different subway lines.
-string getColor(const string &line) {
-    if (line == "1") return "\033[31m";         // red
-    if (line == "2") return "\033[32m";         // green
-    if (line == "3") return "\033[34m";         // blue
-    if (line == "Interchange") return "\033[35m"; // magenta
-    return "\033[0m";                           // default
-}
-
-// Reset color.
-const string reset = "\033[0m";
-
-// Represents a connection from one station to another.
-struct Edge {
-    string destination;
-    int cost;
-    string line; // subway line (e.g., "1", "2", "3")
-};
-
-// Graph class representing the subway system.
-class Graph {
-public:
-    // Adjacency list: station name -> list of edges.
-    unordered_map<string, vector<Edge>> adjList;
-
-    // Add a directed edge from 'from' to 'to'.
-    void addEdge(const string &from, const string &to, int cost, const string &line) {
-        adjList[from].push_back({to, cost, line});
-    }
-
-    // Add a bidirectional edge.
-    void addBidirectionalEdge(const string &s1, const string &s2, int cost, const string &line) {
-        addEdge(s1, s2, cost, line);
-        addEdge(s2, s1, cost, line);
-    }
-
-    // Finds the minimum-cost path from source to destination using Dijkstra's algorithm.
-    // A transfer (switching subway lines) incurs an extra transferCost if the traveling line changes.
-    // Returns a pair: {total cost, vector of {station, line used to reach it}}.
-    pair<int, vector<pair<string, string>>> dijkstra(const string &source, const string &destination, int transferCost) {
-        // Distances from the source.
-        unordered_map<string, int> dist;
-        // For backtracking: map station -> {parent station, line used to get here}
-        unordered_map<string, pair<string, string>> parent;
-
-        // Initialize distances to "infinity".
-        for (auto &pair : adjList) {
-            dist[pair.first] = numeric_limits<int>::max();
-        }
-        dist[source] = 0;
-        // For source, no incoming line.
-        parent[source] = {"", ""};
-
-        // Node structure for the priority queue.
-        struct Node {
-            int cost;
-            string station;
-            string line; // current line used to get to this station.
-            bool operator>(const Node &other) const {
-                return cost > other.cost;
-            }
-        };
-
-        priority_queue<Node, vector<Node>, greater<Node>> pq;
-        pq.push({0, source, ""});
-
-        while (!pq.empty()) {
-            Node current = pq.top();
-            pq.pop();
-            if (current.cost > dist[current.station])
-                continue;
-            if (current.station == destination)
-                break;
-            for (auto &edge : adjList[current.station]) {
-                int extra = 0;
-                // If already on a line and the edge's line is different, add transfer cost.
-                if (!current.line.empty() && current.line != edge.line)
-                    extra = transferCost;
-                int newCost = current.cost + edge.cost + extra;
-                if (newCost < dist[edge.destination]) {
-                    dist[edge.destination] = newCost;
-                    parent[edge.destination] = {current.station, edge.line};
-                    pq.push({newCost, edge.destination, edge.line});
-                }
-            }
-        }
-
-        vector<pair<string, string>> fullPath;
-        if (dist[destination] == numeric_limits<int>::max()) {
-            return {-1, fullPath};  // destination unreachable.
-        }
-        // Reconstruct the path.
-        string cur = destination;
-        while (cur != source) {
-            fullPath.push_back({cur, parent[cur].second});
-            cur = parent[cur].first;
-        }
-        fullPath.push_back({source, ""}); // source has no incoming line.
-        reverse(fullPath.begin(), fullPath.end());
-        return {dist[destination], fullPath};
-    }
-
-    // Display the subway map in a neatly formatted style.
-    void displayMap() {
-        cout << "\nSubway Map:\n";
-        for (const auto &station : adjList) {
-            cout << station.first << ":\n";
-            for (const auto &edge : station.second) {
-                cout << "    -> " << edge.destination << " (" 
-                     << getColor(edge.line) << "Line " << edge.line << reset 
-                     << ", cost " << edge.cost << ")\n";
-            }
-            cout << "\n";
-        }
-    }
-};
-
-// Builds an extended sample subway graph with real NYC subway station names.
-void buildSampleGraph(Graph &graph) {
-    // Line "1"
-    graph.addBidirectionalEdge("Times Sq", "42nd St", 4, "1");
-    graph.addBidirectionalEdge("42nd St", "34th St", 5, "1");
-    graph.addBidirectionalEdge("34th St", "Penn Station", 6, "1");
-
-    // Line "2"
-    graph.addBidirectionalEdge("42nd St", "Grand Central", 3, "2");
-    graph.addBidirectionalEdge("Grand Central", "14th St", 6, "2");
-    graph.addBidirectionalEdge("14th St", "Wall St", 7, "2");
-
-    // Line "3"
-    graph.addBidirectionalEdge("34th St", "Union Sq", 4, "3");
-    graph.addBidirectionalEdge("Union Sq", "Houston St", 7, "3");
-    graph.addBidirectionalEdge("Houston St", "Canal St", 5, "3");
-
-    // Additional interchange scenarios (realistic transfers):
-    // "42nd St" is served by Lines 1 and 2.
-    // "34th St" is served by Lines 1 and 3.
-    // Also, let's assume "Grand Central" and "Union Sq" are close enough to be an interchange.
-    graph.addBidirectionalEdge("Grand Central", "Union Sq", 4, "Interchange");
-}
-
-int main() {
-    Graph graph;
-    // Set transfer cost for switching lines (e.g., 2 units).
-    int transferCost = 2;
-    buildSampleGraph(graph);
-
-    // Display the subway map.
-    graph.displayMap();
-
-    // Create a sorted list of available stations for numbered selection.
-    vector<string> stationList;
-    for (const auto &entry : graph.adjList) {
-        stationList.push_back(entry.first);
-    }
-    sort(stationList.begin(), stationList.end());
-
-    cout << "Welcome to Smart Subway Navigator - NYC\n";
-    cout << "Available stations:\n";
-    for (size_t i = 0; i < stationList.size(); i++) {
-        cout << i+1 << ". " << stationList[i] << "\n";
-    }
-
-    int srcIndex = 0, destIndex = 0;
-    cout << "\nEnter source station number: ";
-    cin >> srcIndex;
-    cout << "Enter destination station number: ";
-    cin >> destIndex;
-
-    // Validate indices.
-    if(srcIndex < 1 || srcIndex > stationList.size() ||
-       destIndex < 1 || destIndex > stationList.size()) {
-        cout << "Invalid station number(s) entered.\n";
-        return 1;
-    }
-    
-    // Map the indices back to station names.
-    string src = stationList[srcIndex - 1];
-    string dest = stationList[destIndex - 1];
-
-    cin.ignore();  // clear the newline.
-
-    auto result = graph.dijkstra(src, dest, transferCost);
-    if (result.first == -1) {
-        cout << "No available path from " << src << " to " << dest << "\n";
-    } else {
-        cout << "\nMinimum cost: " << result.first << "\nRoute Instructions:\n";
-        // Print route instructions with line changes.
-        // result.second is a vector of pair {station, lineUsed to get here}.
-        // The source's associated line is empty.
-        cout << "Start at " << result.second[0].first << "\n";
-        string currentLine = "";
-        for (size_t i = 1; i < result.second.size(); i++) {
-            string station = result.second[i].first;
-            string usedLine = result.second[i].second;
-            if (usedLine != currentLine) {
-                if (!currentLine.empty()) {
-                    cout << "  -> At " << result.second[i-1].first 
-                         << ", transfer to " << getColor(usedLine) 
-                         << "Line " << usedLine << reset << "\n";
-                } else {
-                    cout << "  -> Take " << getColor(usedLine) 
-                         << "Line " << usedLine << reset << "\n";
-                }
-                currentLine = usedLine;
-            }
-            cout << "  -> Arrive at " << station << "\n";
-        }
-    }
-    return 0;
-}
+// Smart Subway Navigator command-line front end. All routing lives in the
+// subway_core library; this file only parses arguments and prints results.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "subway/subway.h"
+
+using namespace subway;
+
+// Parses a clock time "H:MM" or "HH:MM" (00:00 to 23:59) into minutes after midnight.
+bool parseClockTime(const std::string &text, int &minutes) {
+    size_t colon = text.find(':');
+    if (colon == std::string::npos || colon == 0 || colon > 2 || text.size() != colon + 3) return false;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (i != colon && (text[i] < '0' || text[i] > '9')) return false;
+    }
+    int hours = std::atoi(text.substr(0, colon).c_str()), mins = std::atoi(text.substr(colon + 1).c_str());
+    if (hours > 23 || mins > 59) return false;
+    minutes = hours * 60 + mins;
+    return true;
+}
+
+// Harness shared by the benchmark modes: positional arguments after the mode flag,
+// a generated grid network with seeded random queries, timing and result lines.
+struct BenchArgs {
+    int argc;
+    char **argv;
+
+    bool has(int i) const { return i + 2 < argc; }
+    // Integer argument 'i' after the mode flag (0 = first), or 'fallback' when absent.
+    int get(int i, int fallback) const { return has(i) ? std::atoi(argv[i + 2]) : fallback; }
+    std::string text(int i) const { return has(i) ? argv[i + 2] : ""; }
+    // Integer arguments from 'i' on, or 'fallback' when there are none.
+    std::vector<int> list(int i, std::vector<int> fallback) const {
+        std::vector<int> values;
+        for (int a = i + 2; a < argc; a++) values.push_back(std::atoi(argv[a]));
+        return values.empty() ? fallback : values;
+    }
+};
+
+// A generated city of side x side stations.
+struct BenchGrid {
+    Graph graph;
+    int n = 0;
+
+    explicit BenchGrid(int side, unsigned seed = 7) {
+        generateCityNetwork(graph, side, side, seed);
+        n = (int)graph.stationNames.size();
+    }
+
+    const GraphView &view() { return graph.view(0); }
+
+    // 'count' random origin-destination pairs.
+    std::vector<std::pair<int, int>> pairs(int count, unsigned seed) const {
+        std::mt19937 rng(seed);
+        std::vector<std::pair<int, int>> queries;
+        for (int i = 0; i < count; i++) queries.push_back({(int)(rng() % n), (int)(rng() % n)});
+        return queries;
+    }
+
+    // 'count' random {origin, destination, departure} queries leaving in [from, from + span).
+    std::vector<std::array<int, 3>> timedQueries(int count, unsigned seed, int from, int span) const {
+        std::mt19937 rng(seed);
+        std::vector<std::array<int, 3>> queries;
+        for (int i = 0; i < count; i++)
+            queries.push_back({(int)(rng() % n), (int)(rng() % n), from + (int)(rng() % span)});
+        return queries;
+    }
+};
+
+int hardwareThreads() {
+    return (int)std::max(1u, std::thread::hardware_concurrency());
+}
+
+// 'trips' trips between every ordered pair of distinct stations: the default
+// workload of the modes that take an optional OD matrix.
+std::vector<OdDemand> allPairsDemand(const Graph &graph, double trips) {
+    int n = (int)graph.stationNames.size();
+    std::vector<OdDemand> demand;
+    demand.reserve((size_t)n * std::max(0, n - 1));
+    for (int o = 0; o < n; o++)
+        for (int d = 0; d < n; d++)
+            if (o != d) demand.push_back({o, d, trips});
+    return demand;
+}
+
+// Wall-clock seconds taken by 'work'.
+template <class Work>
+double timeSeconds(Work &&work) {
+    auto t0 = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Starts a result line: the label padded to 'width', then queries per second or
+// microseconds per query ('unit' names what was counted). The caller ends the line.
+void printRate(const std::string &label, int width, size_t count, double seconds) {
+    std::cout << "  " << std::left << std::setw(width) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << (seconds > 0 ? count / seconds : 0.0) << " q/s";
+}
+
+void printLatency(const std::string &label, int width, size_t count, double seconds, const char *unit = "query") {
+    std::cout << "  " << std::left << std::setw(width) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << (count ? seconds * 1e6 / count : 0.0) << " us/" << unit;
+}
+
+// Times one kernel instantiation on a query set and checks it against the reference costs.
+template <class Cost, class Id, template <class, class> class Queue>
+void benchKernel(const std::string &label, const GraphView &view, int transferCost,
+                 const std::vector<std::pair<int, int>> &queries, const std::vector<int> &reference) {
+    typedef RoutingKernel<Cost, Id, Queue> Kernel;
+    if (!Kernel::fits(view, transferCost)) {
+        std::cout << "  " << std::left << std::setw(28) << label << std::right << "network does not fit\n";
+        return;
+    }
+    Kernel kernel(view, transferCost);
+    size_t saturated = 0, mismatched = 0;
+    double seconds = timeSeconds([&] {
+        for (size_t i = 0; i < queries.size(); i++) {
+            Cost c = kernel.route((Id)queries[i].first, (Id)queries[i].second);
+            if (c == CostTraits<Cost>::infinity()) {
+                if (reference[i] != -1) saturated++;
+            } else if (CostTraits<Cost>::toDouble(c) != reference[i]) {
+                mismatched++;
+            }
+        }
+    });
+    printRate(label, 28, queries.size(), seconds);
+    std::cout << ", " << std::setw(8) << kernel.memoryBytes() / 1024.0 << " KiB";
+    if (saturated) std::cout << ", " << saturated << " saturated";
+    if (mismatched) std::cout << ", " << mismatched << " mismatched";
+    std::cout << "\n";
+}
+
+// Runs an iterative assignment and prints the loaded segments.
+// Usage: --assign [iterations] [msa|fw] [od matrix]
+// Without a matrix, 100 trips are assigned between every pair of stations.
+int runAssignment(Graph &graph, int transferCost, int argc, char *argv[]) {
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+    AssignmentMethod method = (argc > 3 && std::string(argv[3]) == "msa") ? ASSIGN_MSA : ASSIGN_FRANK_WOLFE;
+    const GraphView &view = graph.view(0);
+
+    std::vector<OdDemand> demand;
+    if (argc > 4) {
+        std::string error;
+        if (!loadOdMatrix(argv[4], graph, demand, error)) {
+            std::cout << "Cannot load OD matrix: " << error << "\n";
+            return 1;
+        }
+    } else {
+        demand = allPairsDemand(graph, 100.0);
+    }
+    std::vector<double> capacity(view.edges.size(), 1000.0);
+
+    int threads = hardwareThreads();
+    AssignmentResult result = assignTraffic(view, demand, transferCost, capacity, method,
+                                            iterations, 1e-4, threads);
+
+    std::cout << "Assignment (" << (method == ASSIGN_MSA ? "MSA" : "Frank-Wolfe") << "): "
+         << result.iterations << " iterations, relative gap " << result.relativeGap << "\n";
+    for (size_t e = 0; e < view.edges.size(); e++) {
+        const ViewEdge &edge = view.edges[e];
+        std::cout << "  " << graph.stationNames[edgeSource(view, (int)e)] << " -> "
+             << graph.stationNames[edge.destination] << " (" << getColor(graph.lineNames[edge.lineId])
+             << "Line " << graph.lineNames[edge.lineId] << reset << "): flow " << std::fixed << std::setprecision(1)
+             << result.flow[e] << ", cost " << edge.cost << " -> " << result.cost[e] << "\n";
+    }
+    return 0;
+}
+
+// Routes every OD pair of a demand matrix and prints line, segment and transfer loads.
+// Usage: --flows <od matrix>
+int runFlowReport(Graph &graph, int transferCost, int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: --flows <od matrix>\n";
+        return 1;
+    }
+    std::vector<OdDemand> demand;
+    std::string error;
+    if (!loadOdMatrix(argv[2], graph, demand, error)) {
+        std::cout << "Cannot load OD matrix: " << error << "\n";
+        return 1;
+    }
+    const GraphView &view = graph.view(0);
+    int threads = hardwareThreads();
+    FlowReport report = aggregateFlows(view, demand, transferCost, graph.lineNames.size(),
+                                       graph.findLine("Interchange"), threads);
+
+    // Per-line totals: boardings, passenger-cost and the busiest segment.
+    std::vector<double> passengerCost(graph.lineNames.size(), 0), peak(graph.lineNames.size(), 0);
+    for (size_t e = 0; e < view.edges.size(); e++) {
+        int line = view.edges[e].lineId;
+        passengerCost[line] += report.edgeFlow[e] * view.edges[e].cost;
+        peak[line] = std::max(peak[line], report.edgeFlow[e]);
+    }
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Line loads:\n";
+    for (size_t l = 0; l < graph.lineNames.size(); l++) {
+        std::cout << "  " << getColor(graph.lineNames[l]) << "Line " << graph.lineNames[l] << reset
+             << ": boardings " << report.boardings[l] << ", passenger-cost " << passengerCost[l]
+             << ", peak segment load " << peak[l] << "\n";
+    }
+    std::cout << "Segment loads:\n";
+    for (size_t e = 0; e < view.edges.size(); e++) {
+        if (report.edgeFlow[e] == 0) continue;
+        const ViewEdge &edge = view.edges[e];
+        std::cout << "  " << graph.stationNames[edgeSource(view, (int)e)] << " -> "
+             << graph.stationNames[edge.destination] << " (" << getColor(graph.lineNames[edge.lineId])
+             << "Line " << graph.lineNames[edge.lineId] << reset << "): " << report.edgeFlow[e] << "\n";
+    }
+    std::cout << "Transfers:\n";
+    for (size_t s = 0; s < report.transfers.size(); s++) {
+        if (report.transfers[s] > 0)
+            std::cout << "  " << graph.stationNames[s] << ": " << report.transfers[s] << "\n";
+    }
+    if (report.unrouted > 0) std::cout << "Unrouted trips: " << report.unrouted << "\n";
+    return 0;
+}
+
+// Prints the top-k stations and segments by betweenness centrality.
+// Usage: --centrality [k] [samples]   (samples > 0 enables the approximate mode)
+int runCentrality(Graph &graph, int transferCost, int argc, char *argv[]) {
+    size_t k = argc > 2 ? (size_t)std::atoi(argv[2]) : 5;
+    int samples = argc > 3 ? std::atoi(argv[3]) : 0;
+    const GraphView &view = graph.view(0);
+    int threads = hardwareThreads();
+    Centrality c = betweennessCentrality(view, transferCost, samples, 42, threads);
+
+    std::vector<int> stations(c.station.size()), edges(c.edge.size());
+    std::iota(stations.begin(), stations.end(), 0);
+    std::iota(edges.begin(), edges.end(), 0);
+    std::sort(stations.begin(), stations.end(), [&](int a, int b) { return c.station[a] > c.station[b]; });
+    std::sort(edges.begin(), edges.end(), [&](int a, int b) { return c.edge[a] > c.edge[b]; });
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Top stations by betweenness" << (samples > 0 ? " (sampled)" : "") << ":\n";
+    for (size_t i = 0; i < std::min(k, stations.size()); i++) {
+        std::cout << "  " << i + 1 << ". " << graph.stationNames[stations[i]] << ": " << c.station[stations[i]] << "\n";
+    }
+    std::cout << "Top segments by betweenness:\n";
+    for (size_t i = 0; i < std::min(k, edges.size()); i++) {
+        const ViewEdge &edge = view.edges[edges[i]];
+        std::cout << "  " << i + 1 << ". " << graph.stationNames[edgeSource(view, edges[i])] << " -> "
+             << graph.stationNames[edge.destination] << " (" << getColor(graph.lineNames[edge.lineId])
+             << "Line " << graph.lineNames[edge.lineId] << reset << "): " << c.edge[edges[i]] << "\n";
+    }
+    return 0;
+}
+
+// Closes every segment in turn and lists the closures by impact on trip costs.
+// Usage: --whatif [od matrix]   (defaults to one trip between every pair of stations)
+int runWhatIf(Graph &graph, int transferCost, int argc, char *argv[]) {
+    std::vector<OdDemand> demand;
+    if (argc > 2) {
+        std::string error;
+        if (!loadOdMatrix(argv[2], graph, demand, error)) {
+            std::cout << "Cannot load OD matrix: " << error << "\n";
+            return 1;
+        }
+    } else {
+        demand = allPairsDemand(graph, 1.0);
+    }
+    const GraphView &view = graph.view(0);
+    int threads = hardwareThreads();
+    std::vector<ClosureImpact> impacts = simulateClosures(view, demand, transferCost, threads);
+    std::sort(impacts.begin(), impacts.end(), [](const ClosureImpact &a, const ClosureImpact &b) {
+        if (a.unservedTrips != b.unservedTrips) return a.unservedTrips > b.unservedTrips;
+        return a.extraCost > b.extraCost;
+    });
+
+    std::cout << std::fixed << std::setprecision(1) << "Segment closures by impact:\n";
+    for (const auto &impact : impacts) {
+        const ViewEdge &edge = view.edges[impact.edges[0]];
+        std::cout << "  " << graph.stationNames[edgeSource(view, impact.edges[0])] << " <-> "
+             << graph.stationNames[edge.destination] << " (" << getColor(graph.lineNames[edge.lineId])
+             << "Line " << graph.lineNames[edge.lineId] << reset << "): extra cost " << impact.extraCost
+             << ", affected trips " << impact.affectedTrips << ", unserved " << impact.unservedTrips
+             << " (" << impact.researchedOrigins << " origins re-searched)\n";
+    }
+    return 0;
+}
+
+// Replays a delay/closure feed and reports update-to-query latency per time slice.
+// Usage: --replay <feed> [slice seconds] [od matrix]
+// The workload defaults to every pair of stations.
+int runReplay(Graph &graph, int transferCost, int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: --replay <feed> [slice seconds] [od matrix]\n";
+        return 1;
+    }
+    std::vector<FeedEvent> events;
+    std::string error;
+    if (!loadEventFeed(argv[2], events, error)) {
+        std::cout << "Cannot load feed: " << error << "\n";
+        return 1;
+    }
+    uint32_t slice = argc > 3 ? (uint32_t)std::max(1, std::atoi(argv[3])) : 60;
+    std::vector<OdDemand> queries;
+    if (argc > 4) {
+        if (!loadOdMatrix(argv[4], graph, queries, error)) {
+            std::cout << "Cannot load OD matrix: " << error << "\n";
+            return 1;
+        }
+    } else {
+        queries = allPairsDemand(graph, 1.0);
+    }
+
+    int threads = hardwareThreads();
+    std::vector<SliceStats> stats = replayFeed(graph.view(0), events, slice, queries, transferCost, threads);
+    double updateMs = 0, queryMs = 0, worst = 0;
+    std::cout << std::fixed << std::setprecision(3);
+    for (const auto &s : stats) {
+        std::cout << "  t=" << s.start << "s: " << s.events << " events, " << s.changedEdges << " edges, update "
+             << s.updateMs << " ms, queries " << s.queryMs << " ms\n";
+        updateMs += s.updateMs;
+        queryMs += s.queryMs;
+        worst = std::max(worst, s.updateMs + s.queryMs);
+    }
+    size_t answered = stats.size() * queries.size();
+    std::cout << "Slices: " << stats.size() << ", events: " << events.size() << ", queries answered: " << answered << "\n";
+    if (!stats.empty()) {
+        std::cout << "Update-to-query latency: mean " << (updateMs + queryMs) / stats.size() << " ms, worst " << worst
+             << " ms\n";
+    }
+    if (updateMs > 0) std::cout << "Update throughput: " << events.size() / (updateMs / 1000) << " events/s\n";
+    if (queryMs > 0) std::cout << "Query throughput: " << answered / (queryMs / 1000) << " queries/s\n";
+    return 0;
+}
+
+// Prints the route between two stations as GeoJSON for map clients: one
+// LineString feature per leg, with its stations and per-segment and cumulative costs.
+// With a departure time the route uses the sample headways and includes the
+// expected waits. Usage: --geojson <from> <to> [y = step-free] [HH:MM]
+int runGeoJson(Graph &graph, int transferCost, int argc, char *argv[]) {
+    int departure = 0;
+    if (argc < 4 || (argc > 5 && !parseClockTime(argv[5], departure))) {
+        std::cout << "Usage: --geojson <from> <to> [y = step-free] [HH:MM]\n";
+        return 1;
+    }
+    int from = graph.findStation(argv[2]), to = graph.findStation(argv[3]);
+    if (from < 0 || to < 0) {
+        std::cout << "Unknown station.\n";
+        return 1;
+    }
+    uint8_t mask = argc > 4 && (argv[4][0] == 'y' || argv[4][0] == 'Y') ? ATTR_INACCESSIBLE : 0;
+    const GraphView &view = graph.view(mask);
+    PackedPath path = argc > 5 ? findPath(view, from, to, transferCost, buildSampleFrequencies(graph), departure)
+                               : findPath(view, from, to, transferCost);
+    if (path.cost == -1 || ((graph.stationAttributes[from] | graph.stationAttributes[to]) & mask)) {
+        std::cout << "{\"type\":\"FeatureCollection\",\"features\":[]}\n";
+        return 0;
+    }
+    ShapeStore shapes = buildSampleShapes(graph);
+    std::vector<PathLeg> legs = unpackPath(view, path, transferCost, &shapes);
+
+    auto list = [](const std::vector<int> &values) {
+        std::string out = "[";
+        for (size_t i = 0; i < values.size(); i++) out += (i ? "," : "") + std::to_string(values[i]);
+        return out + "]";
+    };
+    std::cout << std::fixed << std::setprecision(6);
+    std::cout << "{\"type\":\"FeatureCollection\",\"cost\":" << path.cost << ",\"features\":[";
+    for (size_t l = 0; l < legs.size(); l++) {
+        const PathLeg &leg = legs[l];
+        std::cout << (l ? "," : "") << "\n{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":[";
+        for (size_t i = 0; i < leg.geometry.size(); i++) {
+            std::cout << (i ? "," : "") << "[" << leg.geometry[i].lon / 1e6 << "," << leg.geometry[i].lat / 1e6 << "]";
+        }
+        std::cout << "]},\"properties\":{\"line\":\"" << graph.lineNames[leg.lineId] << "\",\"stations\":[";
+        for (size_t i = 0; i < leg.stations.size(); i++) {
+            std::cout << (i ? "," : "") << "\"" << graph.stationNames[leg.stations[i]] << "\"";
+        }
+        std::cout << "],\"transferPenalty\":" << leg.transferPenalty << ",\"wait\":" << leg.wait
+                  << ",\"segmentCosts\":" << list(leg.segmentCosts)
+                  << ",\"cumulativeCosts\":" << list(leg.cumulativeCosts) << "}}";
+    }
+    std::cout << "]}\n";
+    return 0;
+}
+
+// Writes the sample network, or a generated city, to a binary graph file.
+// Usage: --save-graph <file> [grid side]
+int runSaveGraph(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: --save-graph <file> [grid side]\n";
+        return 1;
+    }
+    Graph graph;
+    if (argc > 3) generateCityNetwork(graph, std::atoi(argv[3]), std::atoi(argv[3]), 1);
+    else buildSampleGraph(graph);
+    std::string error;
+    if (!saveGraph(graph, argv[2], error)) {
+        std::cout << error << "\n";
+        return 1;
+    }
+    std::cout << "Saved " << graph.stationNames.size() << " stations, " << graph.lineNames.size() << " lines, "
+              << graph.edgeCount << " edges\n";
+    return 0;
+}
+
+// Loads a binary graph file and compares name lookups through the stored perfect
+// hash index with the hash map. Usage: --bench-lookup <graph file> [lookups]
+int runLookupBenchmark(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: --bench-lookup <graph file> [lookups]\n";
+        return 1;
+    }
+    Graph graph;
+    std::string error;
+    bool loaded = false;
+    double loadMs = timeSeconds([&] { loaded = loadGraph(graph, argv[2], error); }) * 1e3;
+    if (!loaded) {
+        std::cout << "Cannot load graph: " << error << "\n";
+        return 1;
+    }
+    size_t lookups = argc > 3 ? (size_t)std::atol(argv[3]) : 5000000;
+    const size_t n = graph.stationNames.size();
+    std::mt19937 rng(7);
+    std::vector<std::string> names(std::min<size_t>(lookups, 1 << 16));
+    for (auto &name : names) name = graph.stationNames[rng() % n];
+
+    long long checksum = 0;
+    double mapNs = timeSeconds([&] {
+        for (size_t i = 0; i < lookups; i++) checksum += graph.stationIds.find(names[i % names.size()])->second;
+    }) * 1e9 / lookups;
+    double hashNs = timeSeconds([&] {
+        for (size_t i = 0; i < lookups; i++) checksum -= graph.findStation(names[i % names.size()]);
+    }) * 1e9 / lookups;
+    std::cout << std::fixed << std::setprecision(1) << "Loaded " << n << " stations, " << graph.edgeCount
+              << " edges in " << loadMs << " ms; station index " << graph.stationIndex.memoryBytes() << " bytes\n";
+    std::cout << "  unordered_map lookup: " << mapNs << " ns\n  perfect hash lookup:  " << hashNs << " ns"
+              << (checksum == 0 ? "" : " (MISMATCH)") << "\n";
+    return checksum == 0 ? 0 : 1;
+}
+
+// Measures the mapped CSV query parser on a file of sparse queries, at every SIMD
+// level the CPU supports. Usage: --bench-parse <csv> [grid side]
+// Station names are resolved against the sample network, or a generated city.
+int runParseBenchmark(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: --bench-parse <csv> [grid side]\n";
+        return 1;
+    }
+    Graph graph;
+    if (argc > 3) generateCityNetwork(graph, std::atoi(argv[3]), std::atoi(argv[3]), 1);
+    else buildSampleGraph(graph);
+    const NameIndex &names = graph.stationIndex;
+    MappedFile csv;
+    std::string error;
+    if (!csv.open(argv[2], error)) {
+        std::cout << error << "\n";
+        return 1;
+    }
+    std::vector<QueryBlock> blocks = splitQueryBlocks(csv.data(), csv.size(), 1 << 20);
+    double gigabytes = csv.size() / 1e9;
+    std::cout << std::fixed << std::setprecision(2) << csv.size() / 1e6 << " MB in " << blocks.size()
+              << " blocks, " << graph.stationNames.size() << " stations (name index " << names.memoryBytes()
+              << " bytes)\n";
+    std::vector<uint32_t> separators;
+    std::vector<OdDemand> queries;
+    for (int level = SIMD_SCALAR; level <= bestSimdLevel(); level++) {
+        auto t0 = std::chrono::steady_clock::now();
+        size_t found = 0;
+        for (const auto &b : blocks) {
+            separators.clear();
+            findSeparators(csv.data() + b.begin, b.end - b.begin, (SimdLevel)level, separators);
+            found += separators.size();
+        }
+        double scan = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        t0 = std::chrono::steady_clock::now();
+        size_t parsed = 0;
+        for (const auto &b : blocks) {
+            if (!parseQueryBlock(csv.data() + b.begin, b.end - b.begin, names, (SimdLevel)level, queries, error)) {
+                std::cout << error << "\n";
+                return 1;
+            }
+            parsed += queries.size();
+        }
+        double parse = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "  " << std::left << std::setw(7) << simdLevelName((SimdLevel)level) << std::right
+                  << " separator scan " << std::setw(6) << gigabytes / scan << " GB/s (" << found
+                  << " separators), parse " << std::setw(6) << gigabytes / parse << " GB/s, " << parsed / parse / 1e6
+                  << " M queries/s\n";
+    }
+    return 0;
+}
+
+// Routes an OD workload in parallel and streams the results to a columnar result
+// file. Usage: --batch <out> [od matrix | all] [grid side]
+// With a grid side the workload runs on a generated city instead of the sample network.
+// Sparse binary matrices are streamed: workers take chunks of queries while the next
+// chunk is being read, and finished blocks are written by the result writer's I/O thread.
+int runBatch(Graph &graph, int transferCost, int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: --batch <out> [od matrix | all] [grid side]\n";
+        return 1;
+    }
+    Graph city;
+    Graph &network = argc > 4 ? city : graph;
+    if (argc > 4) generateCityNetwork(city, std::atoi(argv[4]), std::atoi(argv[4]), 1);
+    std::vector<OdDemand> demand;
+    OdStream stream;
+    MappedFile csv;
+    std::vector<QueryBlock> csvBlocks;
+    bool streaming = false, mapped = false;
+    std::string error;
+    if (argc > 3 && std::string(argv[3]) != "all") {
+        streaming = stream.open(argv[3], network, error);
+        // Sparse CSV is parsed in place from a memory mapping, block by block in the workers.
+        mapped = !streaming && csv.open(argv[3], error) && csv.size() >= 4 && csv.data()[0] != ',' &&
+                 std::memcmp(csv.data(), "ODM1", 4) != 0;
+        if (mapped) {
+            csvBlocks = splitQueryBlocks(csv.data(), csv.size(), 1 << 20);
+        } else if (!streaming && !loadOdMatrix(argv[3], network, demand, error)) {
+            std::cout << "Cannot load OD matrix: " << error << "\n";
+            return 1;
+        }
+    } else {
+        demand = allPairsDemand(network, 1.0);
+    }
+
+    ResultWriter writer;
+    if (!writer.open(argv[2], error)) {
+        std::cout << "Cannot write results: " << error << "\n";
+        return 1;
+    }
+    const GraphView &view = network.view(0);
+    const SimdLevel simd = bestSimdLevel();
+    const size_t chunkRows = 1 << 16;
+    std::mutex source;
+    size_t taken = 0;
+    std::atomic<size_t> nextBlock(0), routed(0);
+    std::string inputError;
+    // Hands out the next chunk of queries; false once the workload is done.
+    auto fetch = [&](std::vector<OdDemand> &chunk) {
+        if (mapped) {
+            size_t b = nextBlock++;
+            if (b >= csvBlocks.size()) return false;
+            std::string parseError;
+            if (!parseQueryBlock(csv.data() + csvBlocks[b].begin, csvBlocks[b].end - csvBlocks[b].begin,
+                                 network.stationIndex, simd, chunk, parseError)) {
+                std::lock_guard<std::mutex> lock(source);
+                if (inputError.empty()) inputError = parseError;
+                nextBlock = csvBlocks.size();
+                return false;
+            }
+            routed += chunk.size();
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(source);
+        if (streaming) {
+            bool more = inputError.empty() && stream.next(chunk, chunkRows, inputError);
+            routed += chunk.size();
+            return more;
+        }
+        size_t end = std::min(demand.size(), taken + chunkRows);
+        chunk.assign(demand.begin() + taken, demand.begin() + end);
+        routed += end - taken;
+        taken = end;
+        return !chunk.empty();
+    };
+    auto worker = [&]() {
+        SearchTree tree;
+        ResultBlock block;
+        std::vector<OdDemand> chunk;
+        while (fetch(chunk)) {
+            std::stable_sort(chunk.begin(), chunk.end(),
+                             [](const OdDemand &a, const OdDemand &b) { return a.origin < b.origin; });
+            for (size_t i = 0; i < chunk.size(); i++) {
+                if (i == 0 || chunk[i].origin != chunk[i - 1].origin)
+                    buildSearchTree(view, chunk[i].origin, transferCost, tree);
+                block.add(chunk[i].origin, chunk[i].destination, treeRoute(view, tree, chunk[i].destination));
+            }
+            if (block.rows()) writer.submit(block);
+            block.clear();
+        }
+    };
+    auto t0 = std::chrono::steady_clock::now();
+    int threads = hardwareThreads();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+    bool written = writer.close(error);
+    if (!inputError.empty()) {
+        std::cout << "Cannot read OD matrix: " << inputError << "\n";
+        return 1;
+    }
+    if (!written) {
+        std::cout << "Cannot write results: " << error << "\n";
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << std::fixed << std::setprecision(1) << "Routed " << routed << " queries in " << seconds << " s ("
+              << routed / seconds << " rows/s), " << writer.bytesWritten() << " bytes written ("
+              << (double)writer.bytesWritten() / std::max<size_t>(1, routed) << " bytes/row), I/O via "
+              << (writer.usingUring() ? "io_uring" : "pread/pwrite") << (streaming ? ", streamed input" : "")
+              << (mapped ? std::string(", mapped CSV (") + simdLevelName(simd) + ")" : "") << "\n";
+    return 0;
+}
+
+// Summarizes a result file written by --batch. Usage: --results <file>
+int runResults(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: --results <file>\n";
+        return 1;
+    }
+    ResultReader reader;
+    std::string error;
+    if (!reader.open(argv[2], error)) {
+        std::cout << error << "\n";
+        return 1;
+    }
+    ResultBlock block;
+    size_t blocks = 0, rows = 0, legs = 0, unreachable = 0;
+    double costSum = 0;
+    while (reader.next(block, error)) {
+        blocks++;
+        rows += block.rows();
+        legs += block.legBoard.size();
+        for (int32_t c : block.cost) {
+            if (c < 0) unreachable++;
+            else costSum += c;
+        }
+    }
+    if (!error.empty()) {
+        std::cout << "Cannot read results: " << error << "\n";
+        return 1;
+    }
+    std::cout << std::fixed << std::setprecision(2) << blocks << " blocks, " << rows << " rows, " << legs << " legs, "
+              << unreachable << " unreachable, mean cost "
+              << (rows > unreachable ? costSum / (rows - unreachable) : 0.0) << "\n";
+    return 0;
+}
+
+// Interactive route finder over the compile-time sample network. Nothing is built
+// at startup, so this is the mode for embedded kiosks.
+int runKiosk(int transferCost) {
+    const auto &net = kSampleNetwork;
+    std::cout << "Welcome to Smart Subway Navigator - NYC\n";
+    std::cout << "Available stations:\n";
+    for (size_t i = 0; i < net.stationNames.size(); i++) {
+        std::cout << i + 1 << ". " << net.stationNames[i] << "\n";
+    }
+    int srcIndex = 0, destIndex = 0;
+    std::cout << "\nEnter source station number: ";
+    std::cin >> srcIndex;
+    std::cout << "Enter destination station number: ";
+    std::cin >> destIndex;
+    int n = (int)net.stationNames.size();
+    if (srcIndex < 1 || srcIndex > n || destIndex < 1 || destIndex > n) {
+        std::cout << "Invalid station number(s) entered.\n";
+        return 1;
+    }
+
+    auto route = staticRoute(net, srcIndex - 1, destIndex - 1, transferCost);
+    if (route.cost == -1) {
+        std::cout << "No available path from " << net.stationNames[srcIndex - 1] << " to "
+             << net.stationNames[destIndex - 1] << "\n";
+        return 0;
+    }
+    std::cout << "\nMinimum cost: " << route.cost << "\nRoute Instructions:\n";
+    std::cout << "Start at " << net.stationNames[route.stations[0]] << "\n";
+    int currentLine = -1;
+    for (int i = 1; i <= route.stops; i++) {
+        int usedLine = route.lines[i];
+        if (usedLine != currentLine) {
+            std::string line(net.lineNames[usedLine]);
+            if (currentLine != -1) {
+                std::cout << "  -> At " << net.stationNames[route.stations[i - 1]] << ", transfer to "
+                     << getColor(line) << "Line " << line << reset << "\n";
+            } else {
+                std::cout << "  -> Take " << getColor(line) << "Line " << line << reset << "\n";
+            }
+            currentLine = usedLine;
+        }
+        std::cout << "  -> Arrive at " << net.stationNames[route.stations[i]] << "\n";
+    }
+    return 0;
+}
+
+// Benchmarks every routing kernel instantiation against Graph::dijkstra on a
+// generated grid network. Usage: --bench-kernels [grid side] [queries]
+int runKernelBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 100));
+    int count = args.get(1, 1000);
+    const GraphView &view = grid.view();
+    std::vector<std::pair<int, int>> queries = grid.pairs(count, 11);
+
+    std::vector<int> reference;
+    double seconds = timeSeconds([&] {
+        for (auto &q : queries) {
+            reference.push_back(grid.graph.dijkstra(grid.graph.stationNames[q.first], grid.graph.stationNames[q.second],
+                                                    transferCost, view).first);
+        }
+    });
+    std::cout << grid.n << " stations, " << view.edges.size() << " edges, " << count << " queries\n";
+    printRate("Graph::dijkstra (int)", 28, count, seconds);
+    std::cout << "\n";
+
+    benchKernel<uint16_t, uint16_t, HeapQueue>("uint16 cost/id, heap", view, transferCost, queries, reference);
+    benchKernel<uint16_t, uint16_t, BucketQueue>("uint16 cost/id, buckets", view, transferCost, queries, reference);
+    benchKernel<uint32_t, uint32_t, HeapQueue>("uint32 cost/id, heap", view, transferCost, queries, reference);
+    benchKernel<uint32_t, uint32_t, BucketQueue>("uint32 cost/id, buckets", view, transferCost, queries, reference);
+    benchKernel<FixedCost, uint32_t, HeapQueue>("16.16 fixed cost, heap", view, transferCost, queries, reference);
+    return 0;
+}
+
+// Compares the plain point-to-point loop with coroutine-interleaved execution at
+// several group sizes on a generated grid network, checking every result against
+// findPath. Usage: --bench-interleave [grid side] [queries] [group...]
+int runInterleaveBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 400));
+    int count = args.get(1, 200);
+    std::vector<int> groups = args.list(2, {2, 4, 8, 16});
+    const GraphView &view = grid.view();
+    std::vector<std::pair<int, int>> queries = grid.pairs(count, 13);
+    std::vector<int> reference;
+    for (auto &q : queries) reference.push_back(findPath(view, q.first, q.second, transferCost).cost);
+
+    std::cout << grid.n << " stations, " << view.edges.size() << " edges, " << count << " queries"
+              << (interleavingAvailable() ? "" : " (built without coroutines)") << "\n";
+    auto run = [&](const std::string &label, int group) {
+        std::vector<int> costs;
+        double seconds = timeSeconds([&] { costs = interleavedCosts(view, queries, transferCost, group); });
+        printRate(label, 16, count, seconds);
+        std::cout << (costs == reference ? "" : "  MISMATCH") << "\n";
+    };
+    run("plain loop", 1);
+    for (int group : groups) run("group of " + std::to_string(group), group);
+    return 0;
+}
+
+// Measures software prefetching in the point-to-point relaxation loop at several
+// prefetch distances (0 = off) on a generated grid network, with hardware counters
+// where the machine exposes them. Usage: --bench-prefetch [grid side] [queries] [distance...]
+int runPrefetchBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 500));
+    int count = args.get(1, 100);
+    std::vector<int> distances = args.list(2, {0, 1, 2, 4, 8});
+    const GraphView &view = grid.view();
+    std::vector<std::pair<int, int>> queries = grid.pairs(count, 17);
+
+    PerfCounters counters;
+    std::string error;
+    if (!counters.open(error)) std::cout << "Counters unavailable (" << error << ")\n";
+    std::cout << grid.n << " stations, " << view.edges.size() << " edges, " << count << " queries\n";
+    std::cout << "  " << std::left << std::setw(10) << "distance" << std::right << std::setw(14) << "throughput";
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (counters.available((PerfEvent)e)) std::cout << std::setw(15) << perfEventName((PerfEvent)e);
+    }
+    std::cout << "\n";
+
+    std::vector<int> reference;
+    for (int distance : distances) {
+        std::vector<int> costs;
+        counters.start();
+        double seconds = timeSeconds([&] {
+            for (auto &q : queries) costs.push_back(findPath(view, q.first, q.second, transferCost, distance).cost);
+        });
+        PerfReading reading = counters.stop();
+        if (reference.empty()) reference = costs;
+        printRate(std::to_string(distance), 10, count, seconds);
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (reading.valid[e]) std::cout << std::setw(15) << reading.value[e] / count;
+        }
+        std::cout << (costs == reference ? "" : "  MISMATCH") << "\n";
+    }
+    std::cout << "Counter values are per query.\n";
+    return 0;
+}
+
+// Builds arc flags for a generated grid network and compares flagged search with
+// findPath: throughput, stations settled and identical paths.
+// Usage: --bench-arcflags [grid side] [regions] [queries]
+int runArcFlagsBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 30));
+    int regions = args.get(1, 16);
+    int count = args.get(2, 2000);
+    const GraphView &view = grid.view();
+
+    ArcFlags arcFlags;
+    double buildSeconds = timeSeconds([&] { arcFlags = buildArcFlags(view, transferCost, regions, hardwareThreads()); });
+    size_t set = 0;
+    for (uint64_t flags : arcFlags.flags) set += __builtin_popcountll(flags);
+    std::cout << grid.n << " stations, " << view.edges.size() << " edges, " << arcFlags.regionCount
+              << " regions, flags built in " << std::fixed << std::setprecision(2) << buildSeconds << " s ("
+              << std::setprecision(1) << 100.0 * set / (view.edges.size() * arcFlags.regionCount)
+              << "% of edge flags set)\n";
+
+    std::vector<std::pair<int, int>> queries = grid.pairs(count, 19);
+    std::vector<PackedPath> plain, flagged;
+    double plainSeconds = timeSeconds([&] {
+        for (auto &q : queries) plain.push_back(findPath(view, q.first, q.second, transferCost));
+    });
+    double flaggedSeconds = timeSeconds([&] {
+        for (auto &q : queries) flagged.push_back(findPathArcFlags(view, arcFlags, q.first, q.second, transferCost));
+    });
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        if (plain[i].cost != flagged[i].cost || plain[i].edges != flagged[i].edges) mismatches++;
+    }
+    printRate("findPath", 13, count, plainSeconds);
+    std::cout << "\n";
+    printRate("arc flags", 13, count, flaggedSeconds);
+    std::cout << " (" << std::setprecision(2) << plainSeconds / flaggedSeconds << "x), " << mismatches
+              << " paths differ\n";
+    return 0;
+}
+
+// Builds transit node routing tables for a generated grid network and compares
+// table and local queries with line-graph Dijkstra.
+// Usage: --bench-tnr [grid side] [hubs] [queries]
+int runTransitNodeBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 40));
+    int hubCount = args.get(1, 128);
+    int count = args.get(2, 2000);
+    const GraphView &view = grid.view();
+    int n = grid.n;
+
+    TransitNodes tnr;
+    double buildSeconds =
+        timeSeconds([&] { tnr = buildTransitNodes(view, transferCost, hubCount, 200, hardwareThreads()); });
+    std::cout << n << " stations, " << tnr.hubs.size() << " hubs (" << tnr.hubNodes.size() << " table nodes), built in "
+              << std::fixed << std::setprecision(2) << buildSeconds << " s, " << tnr.memoryBytes() / 1024 << " KiB, "
+              << std::setprecision(1) << (double)tnr.access.size() / n << " access / "
+              << (double)tnr.egress.size() / n << " egress entries and " << (double)tnr.local.size() / n
+              << " local stations per station\n";
+
+    std::vector<std::pair<int, int>> queries = grid.pairs(count, 23);
+    std::vector<int> reference;
+    double referenceSeconds = timeSeconds([&] {
+        for (auto &q : queries) reference.push_back(lineGraphCost(tnr.lineGraph, q.first, q.second));
+    });
+
+    double farSeconds = 0, nearSeconds = 0;
+    int far = 0, mismatches = 0;
+    for (size_t i = 0; i < queries.size(); i++) {
+        bool local = false;
+        int cost = 0;
+        double seconds = timeSeconds([&] { cost = transitNodeCost(tnr, queries[i].first, queries[i].second, &local); });
+        (local ? nearSeconds : farSeconds) += seconds;
+        far += !local;
+        mismatches += cost != reference[i];
+    }
+    printLatency("line-graph Dijkstra", 20, count, referenceSeconds);
+    std::cout << "\n";
+    printLatency("table (far)", 20, far, farSeconds);
+    std::cout << ", " << far << " queries\n";
+    printLatency("local (near)", 20, count - far, nearSeconds);
+    std::cout << ", " << count - far << " queries\n";
+    std::cout << "  " << mismatches << " costs differ\n";
+    return 0;
+}
+
+// Builds a timetable for a generated grid network, precomputes Trip-Based transfers
+// and compares earliest-arrival and profile queries with RAPTOR. With a file, the
+// transfers are saved to and reloaded from a binary graph file first.
+// Usage: --bench-tripbased [grid side] [headway] [queries] [graph file]
+int runTripBasedBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 20));
+    int headway = args.get(1, 6);
+    int count = args.get(2, 1000);
+    const GraphView &view = grid.view();
+
+    TripBased tb;
+    double buildSeconds = timeSeconds([&] {
+        tb = buildTripBased(buildTimetable(grid.graph, view, headway, 300, 1440, transferCost), hardwareThreads());
+    });
+    if (args.has(3)) {
+        std::string error;
+        Graph loaded;
+        TripBased loadedTb;
+        if (!saveGraph(grid.graph, args.text(3), error, &tb) || !loadGraph(loaded, args.text(3), error, &loadedTb)) {
+            std::cout << error << "\n";
+            return 1;
+        }
+        tb = std::move(loadedTb);
+    }
+    const Timetable &tt = tb.timetable;
+    std::cout << grid.n << " stations, " << tt.routeCount() << " routes, " << tt.tripCount() << " trips, "
+              << tb.transfers.size() << " transfers built in " << std::fixed << std::setprecision(2) << buildSeconds
+              << " s, " << tb.memoryBytes() / 1024 << " KiB\n";
+
+    std::vector<std::array<int, 3>> queries = grid.timedQueries(count, 29, 300, 900);
+    std::vector<int> reference;
+    double raptorSeconds = timeSeconds([&] {
+        for (auto &q : queries) reference.push_back(raptorArrival(tt, q[0], q[1], q[2]));
+    });
+    TripBasedQuery query(tb);
+    int mismatches = 0;
+    double tbSeconds = timeSeconds([&] {
+        for (int i = 0; i < count; i++)
+            mismatches += query.earliestArrival(queries[i][0], queries[i][1], queries[i][2]) != reference[i];
+    });
+
+    // One-hour profiles; every entry must match RAPTOR from its departure with as many trips.
+    int profiles = std::min(count, 100);
+    size_t entries = 0;
+    int profileMismatches = 0;
+    std::vector<std::vector<ProfileEntry>> results;
+    double profileSeconds = timeSeconds([&] {
+        for (int i = 0; i < profiles; i++)
+            results.push_back(query.profile(queries[i][0], queries[i][1], queries[i][2], queries[i][2] + 60));
+    });
+    for (int i = 0; i < profiles; i++) {
+        entries += results[i].size();
+        for (const ProfileEntry &e : results[i]) {
+            profileMismatches += raptorArrival(tt, queries[i][0], queries[i][1], e.departure, e.transfers + 1) != e.arrival;
+        }
+    }
+    printLatency("RAPTOR", 17, count, raptorSeconds);
+    std::cout << "\n";
+    printLatency("Trip-Based", 17, count, tbSeconds);
+    std::cout << ", " << mismatches << " arrivals differ\n";
+    printLatency("Trip-Based 1h", 17, profiles, profileSeconds, "profile");
+    std::cout << ", " << std::setprecision(1) << (double)entries / profiles << " journeys, " << profileMismatches
+              << " differ\n";
+    return 0;
+}
+
+// Precomputes transfer patterns for a generated grid network and compares pattern
+// queries with RAPTOR. With a progress file the build resumes from the origins
+// already in it; with an origin budget it stops after that many new origins.
+// Usage: --bench-patterns [grid side] [headway] [queries] [progress file] [origin budget]
+int runTransferPatternsBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 12));
+    int headway = args.get(1, 6);
+    int count = args.get(2, 2000);
+    std::string progressPath = args.text(3);
+    int budget = args.get(4, -1);
+    const GraphView &view = grid.view();
+    int n = grid.n;
+
+    TransferPatterns patterns;
+    std::string error;
+    int resumed = 0;
+    bool complete = false;
+    double buildSeconds = timeSeconds([&] {
+        complete = buildTransferPatterns(buildTimetable(grid.graph, view, headway, 300, 1440, transferCost), 300, 1440,
+                                         8, hardwareThreads(), progressPath, budget, patterns, error, &resumed);
+    });
+    if (!complete) {
+        std::cout << error << "\n";
+        return 1;
+    }
+    std::cout << n << " stations, patterns built in " << std::fixed << std::setprecision(2) << buildSeconds << " s ("
+              << resumed << " origins resumed), " << std::setprecision(1) << (double)patterns.nodes.size() / n
+              << " nodes per origin, " << (double)patterns.targetNodes.size() / ((double)n * n)
+              << " patterns per pair, " << patterns.memoryBytes() / 1024 << " KiB\n";
+
+    std::vector<std::array<int, 3>> queries = grid.timedQueries(count, 31, 300, 900);
+    std::vector<int> reference;
+    double raptorSeconds = timeSeconds([&] {
+        for (auto &q : queries) reference.push_back(raptorArrival(patterns.timetable, q[0], q[1], q[2], patterns.maxTrips));
+    });
+    std::vector<std::vector<PatternJourney>> results;
+    double patternSeconds = timeSeconds([&] {
+        for (auto &q : queries) results.push_back(transferPatternQuery(patterns, q[0], q[1], q[2]));
+    });
+    // The fastest journey must match RAPTOR, and every other one RAPTOR with as many trips.
+    int mismatches = 0;
+    size_t journeys = 0;
+    for (int i = 0; i < count; i++) {
+        const std::vector<PatternJourney> &result = results[i];
+        journeys += result.size();
+        bool same = (result.empty() ? -1 : result.back().arrival) == reference[i];
+        for (const PatternJourney &j : result)
+            same = same && raptorArrival(patterns.timetable, queries[i][0], queries[i][1], queries[i][2], j.trips) == j.arrival;
+        mismatches += !same;
+    }
+    printLatency("RAPTOR", 18, count, raptorSeconds);
+    std::cout << "\n";
+    printLatency("transfer patterns", 18, count, patternSeconds);
+    std::cout << ", " << std::setprecision(1) << (double)journeys / count << " Pareto journeys, " << mismatches
+              << " answers differ\n";
+    return 0;
+}
+
+// Gives every line of a generated grid network headway bands (night, peaks, midday)
+// and compares frequency-based searches at several departure times with the static
+// search: throughput, expected journey time and how many routes change.
+// Usage: --bench-frequency [grid side] [queries]
+int runFrequencyBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    BenchGrid grid(args.get(0, 30));
+    int count = args.get(1, 2000);
+    const GraphView &view = grid.view();
+    std::mt19937 rng(37);
+    FrequencyModel frequencies = grid.graph.makeFrequencyModel(10);
+    for (int l = 0; l < (int)grid.graph.lineNames.size(); l++) {
+        uint16_t peak = (uint16_t)(2 + rng() % 5);
+        frequencies.setBands(l, {{0, (uint16_t)(peak * 5)}, {360, (uint16_t)(peak * 2)}, {420, peak},
+                                 {600, (uint16_t)(peak * 3 / 2)}, {960, peak}, {1140, (uint16_t)(peak * 2)}});
+    }
+    std::cout << grid.n << " stations, " << grid.graph.lineNames.size() << " lines, " << frequencies.bands.size()
+              << " headway bands (" << frequencies.bands.size() * sizeof(HeadwayBand) + frequencies.bandOffsets.size() * sizeof(int)
+              << " bytes)\n";
+
+    std::vector<std::pair<int, int>> queries = grid.pairs(count, 41);
+    std::vector<Route> fixed;
+    double fixedSeconds = timeSeconds([&] {
+        for (auto &q : queries) fixed.push_back(findRoute(view, q.first, q.second, transferCost));
+    });
+    printRate("static costs", 15, count, fixedSeconds);
+    std::cout << "\n";
+    for (int departure : {180, 480, 720}) {
+        std::vector<Route> expected;
+        double seconds = timeSeconds([&] {
+            for (auto &q : queries) expected.push_back(findRoute(view, q.first, q.second, transferCost, frequencies, departure));
+        });
+        double staticCost = 0, expectedCost = 0;
+        int changed = 0;
+        for (int i = 0; i < count; i++) {
+            staticCost += fixed[i].cost;
+            expectedCost += expected[i].cost;
+            bool same = fixed[i].legs.size() == expected[i].legs.size();
+            for (size_t l = 0; same && l < fixed[i].legs.size(); l++) {
+                const RouteLeg &a = fixed[i].legs[l], &b = expected[i].legs[l];
+                same = a.board == b.board && a.alight == b.alight && a.lineId == b.lineId;
+            }
+            changed += !same;
+        }
+        char label[32];
+        std::snprintf(label, sizeof(label), "depart %02d:%02d", departure / 60, departure % 60);
+        printRate(label, 15, count, seconds);
+        std::cout << ", expected " << expectedCost / count << " vs static " << staticCost / count << ", " << changed
+                  << " routes change\n";
+    }
+    return 0;
+}
+
+// Runs a representative query mix on a generated city network and reports throughput.
+// This is the workload the PGO pipeline trains on. Usage: --bench [grid side] [queries] [seed]
+// Mix: 64% point-to-point, 10% step-free, 2% fare-aware, 12% one-to-all trees,
+// 12% bucket-queue kernel queries.
+int runBenchmark(int transferCost, int argc, char *argv[]) {
+    BenchArgs args{argc, argv};
+    unsigned seed = (unsigned)args.get(2, 1);
+    BenchGrid grid(args.get(0, 100), seed);
+    int count = args.get(1, 2000);
+    Graph &graph = grid.graph;
+    int n = grid.n;
+    std::mt19937 rng(seed + 1);
+    for (int s = 0; s < n; s++) {
+        if (rng() % 10 == 0) graph.setStationAttributes(graph.stationNames[s], ATTR_INACCESSIBLE);
+    }
+    graph.prepareViews({0, ATTR_INACCESSIBLE});
+    const GraphView &full = graph.view(0);
+    const GraphView &stepFree = graph.view(ATTR_INACCESSIBLE);
+    FareModel fares = graph.makeFareModel(290, 40);
+    for (size_t l = 0; l < graph.lineNames.size(); l += 5) fares.surcharge[l] = 100;
+    RoutingKernel<uint32_t, uint32_t, BucketQueue> kernel(full, transferCost);
+    SearchTree tree;
+
+    long long checksum = 0;
+    int kinds[5] = {0, 0, 0, 0, 0};
+    double seconds = timeSeconds([&] {
+        for (int i = 0; i < count; i++) {
+            int a = (int)(rng() % n), b = (int)(rng() % n);
+            int kind = (int)(rng() % 50);
+            if (kind < 32) {
+                checksum += graph.dijkstra(graph.stationNames[a], graph.stationNames[b], transferCost, full).first;
+                kinds[0]++;
+            } else if (kind < 37) {
+                checksum += graph.dijkstra(graph.stationNames[a], graph.stationNames[b], transferCost, stepFree).first;
+                kinds[1]++;
+            } else if (kind == 37) {
+                checksum += graph.fareAwareRoutes(graph.stationNames[a], graph.stationNames[b], transferCost, fares, full).size();
+                kinds[2]++;
+            } else if (kind < 44) {
+                buildSearchTree(full, a, transferCost, tree);
+                checksum += tree.dist[b];
+                kinds[3]++;
+            } else {
+                checksum += kernel.route((uint32_t)a, (uint32_t)b);
+                kinds[4]++;
+            }
+        }
+    });
+    std::cout << n << " stations, " << full.edges.size() << " edges, " << count << " queries ("
+              << kinds[0] << " point-to-point, " << kinds[1] << " step-free, " << kinds[2] << " fare-aware, "
+              << kinds[3] << " one-to-all, " << kinds[4] << " kernel), checksum " << checksum << "\n";
+    std::cout << "Query mix throughput: " << std::fixed << std::setprecision(1) << count / seconds
+              << " queries/s\n";
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        return runBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-kernels") {
+        return runKernelBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-interleave") {
+        return runInterleaveBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-prefetch") {
+        return runPrefetchBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-arcflags") {
+        return runArcFlagsBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-tnr") {
+        return runTransitNodeBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-tripbased") {
+        return runTripBasedBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-patterns") {
+        return runTransferPatternsBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-frequency") {
+        return runFrequencyBenchmark(2, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--save-graph") {
+        return runSaveGraph(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-lookup") {
+        return runLookupBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-parse") {
+        return runParseBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--results") {
+        return runResults(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--kiosk") {
+        return runKiosk(2);
+    }
+
+    Graph graph;
+    // Set transfer cost for switching lines (e.g., 2 units).
+    int transferCost = 2;
+    buildSampleGraph(graph);
+    // Views for the default and step-free queries are built once up front.
+    graph.prepareViews({0, ATTR_INACCESSIBLE});
+
+    if (argc > 1 && std::string(argv[1]) == "--assign") {
+        return runAssignment(graph, transferCost, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--flows") {
+        return runFlowReport(graph, transferCost, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--centrality") {
+        return runCentrality(graph, transferCost, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--whatif") {
+        return runWhatIf(graph, transferCost, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--replay") {
+        return runReplay(graph, transferCost, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        return runBatch(graph, transferCost, argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--geojson") {
+        return runGeoJson(graph, transferCost, argc, argv);
+    }
+
+    // Display the subway map.
+    graph.displayMap();
+
+    // Create a sorted list of available stations for numbered selection.
+    std::vector<std::string> stationList;
+    for (const auto &entry : graph.adjList) {
+        stationList.push_back(entry.first);
+    }
+    std::sort(stationList.begin(), stationList.end());
+
+    std::cout << "Welcome to Smart Subway Navigator - NYC\n";
+    std::cout << "Available stations:\n";
+    for (size_t i = 0; i < stationList.size(); i++) {
+        std::cout << i+1 << ". " << stationList[i] << "\n";
+    }
+
+    int srcIndex = 0, destIndex = 0;
+    std::cout << "\nEnter source station number: ";
+    std::cin >> srcIndex;
+    std::cout << "Enter destination station number: ";
+    std::cin >> destIndex;
+
+    // Validate indices.
+    int stationCount = (int)stationList.size();
+    if(srcIndex < 1 || srcIndex > stationCount ||
+       destIndex < 1 || destIndex > stationCount) {
+        std::cout << "Invalid station number(s) entered.\n";
+        return 1;
+    }
+    
+    // Map the indices back to station names.
+    std::string src = stationList[srcIndex - 1];
+    std::string dest = stationList[destIndex - 1];
+
+    char stepFree = 'n';
+    std::cout << "Require step-free access (y/n): ";
+    std::cin >> stepFree;
+    uint8_t mask = (stepFree == 'y' || stepFree == 'Y') ? ATTR_INACCESSIBLE : 0;
+
+    // A departure time switches to the frequency-based model with expected waits.
+    std::string departure;
+    int departureTime = 0;
+    bool frequencyBased = false;
+    while (true) {
+        std::cout << "Departure time for expected waits (HH:MM, or n for static costs): ";
+        if (!(std::cin >> departure) || departure == "n" || departure == "N") break;
+        if ((frequencyBased = parseClockTime(departure, departureTime))) break;
+        std::cout << "Invalid time; use 00:00 to 23:59.\n";
+    }
+
+    std::cin.ignore(); // clear the newline.
+
+    Route route;
+    int srcId = graph.findStation(src), destId = graph.findStation(dest);
+    if (!((graph.stationAttributes[srcId] | graph.stationAttributes[destId]) & mask)) {
+        route = frequencyBased ? findRoute(graph.view(mask), srcId, destId, transferCost,
+                                           buildSampleFrequencies(graph), departureTime)
+                               : findRoute(graph.view(mask), srcId, destId, transferCost);
+    }
+    if (route.cost == -1) {
+        std::cout << "No available path from " << src << " to " << dest << "\n";
+    } else {
+        std::cout << (frequencyBased ? "\nExpected journey time: " : "\nMinimum cost: ") << route.cost
+                  << "\nRoute Instructions:\n";
+        std::cout << "Start at " << src << "\n";
+        for (size_t i = 0; i < route.legs.size(); i++) {
+            const RouteLeg &leg = route.legs[i];
+            const std::string &line = graph.lineNames[leg.lineId];
+            if (i == 0) {
+                std::cout << "  -> Take " << getColor(line) << "Line " << line << reset << "\n";
+            } else {
+                std::cout << "  -> At " << graph.stationNames[leg.board] << ", transfer to " << getColor(line)
+                          << "Line " << line << reset << "\n";
+            }
+            std::cout << "  -> Ride " << leg.stops << (leg.stops == 1 ? " stop" : " stops") << " to "
+                      << graph.stationNames[leg.alight] << " (cost " << leg.cost << ")\n";
+        }
+
+        // Trade-offs between travel cost and fare.
+        std::vector<FareRoute> fareRoutes = graph.fareAwareRoutes(src, dest, transferCost, buildSampleFares(graph),
+                                                                  graph.view(mask));
+        std::cout << "\nFare options:\n";
+        for (const auto &route : fareRoutes) {
+            std::cout << "  cost " << route.time << ", fare $" << route.fare / 100 << "."
+                 << std::setw(2) << std::setfill('0') << route.fare % 100 << std::setfill(' ') << ":";
+            for (size_t i = 0; i < route.path.size(); i++) {
+                std::cout << (i ? " -> " : " ") << route.path[i].first;
+            }
+            std::cout << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+# Profile-guided optimization pipeline, run by the 'pgo' target:
+#   1. baseline build, benchmark
+#   2. instrumented build (SUBWAY_PGO=GENERATE), training run of the benchmark
+#   3. optimized build (SUBWAY_PGO=USE), benchmark
+#   4. optionally, BOLT post-link layout of the optimized binary, benchmark
+# Training and evaluation use different seeds of the generated city network.
+#
+# Inputs: SOURCE_DIR, WORK_DIR, CXX_COMPILER, BENCH_ARGS ("<grid side> <queries>"), BOLT (ON/OFF).
+
+set(BENCH_LABEL "${BENCH_ARGS}")
+separate_arguments(BENCH_ARGS UNIX_COMMAND "${BENCH_ARGS}")
+set(PROFILE_DIR "${WORK_DIR}/profiles")
+
+function(build_variant name)
+    set(dir "${WORK_DIR}/${name}")
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${dir} -DCMAKE_BUILD_TYPE=Release
+                -DCMAKE_CXX_COMPILER=${CXX_COMPILER} -DSUBWAY_PGO_DIR=${PROFILE_DIR} ${ARGN}
+        RESULT_VARIABLE result OUTPUT_QUIET)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Configuring the ${name} build failed")
+    endif()
+    execute_process(COMMAND ${CMAKE_COMMAND} --build ${dir} --target subway_cli --parallel
+                    RESULT_VARIABLE result OUTPUT_QUIET)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Building the ${name} variant failed")
+    endif()
+endfunction()
+
+# Runs the benchmark with 'seed' and stores its queries/s (integer part) in 'out'.
+function(run_bench exe seed out)
+    execute_process(COMMAND ${exe} --bench ${BENCH_ARGS} ${seed}
+                    OUTPUT_VARIABLE output RESULT_VARIABLE result)
+    if(NOT result EQUAL 0 OR NOT output MATCHES "Query mix throughput: ([0-9]+)")
+        message(FATAL_ERROR "Benchmark run of ${exe} failed:\n${output}")
+    endif()
+    set(${out} ${CMAKE_MATCH_1} PARENT_SCOPE)
+    message(STATUS "  ${exe}: ${CMAKE_MATCH_1} queries/s")
+endfunction()
+
+# Formats new/old as "N.NNNx".
+function(format_speedup new old out)
+    math(EXPR ratio "${new} * 1000 / ${old}")
+    math(EXPR whole "${ratio} / 1000")
+    math(EXPR frac "${ratio} % 1000")
+    string(LENGTH "${frac}" len)
+    while(len LESS 3)
+        set(frac "0${frac}")
+        string(LENGTH "${frac}" len)
+    endwhile()
+    set(${out} "${whole}.${frac}x" PARENT_SCOPE)
+endfunction()
+
+message(STATUS "PGO: baseline build")
+build_variant(baseline -DSUBWAY_PGO=)
+run_bench(${WORK_DIR}/baseline/subway_cli 2 baseline_qps)
+
+message(STATUS "PGO: instrumented build and training run")
+file(REMOVE_RECURSE ${PROFILE_DIR})
+build_variant(instrumented -DSUBWAY_PGO=GENERATE)
+run_bench(${WORK_DIR}/instrumented/subway_cli 1 unused)
+# The optimized build fails on any object without a profile (-Werror=missing-profile
+# for GCC, a missing merged.profdata for Clang), so an empty training run stops here.
+if(CXX_COMPILER MATCHES "clang")
+    find_program(LLVM_PROFDATA NAMES llvm-profdata llvm-profdata-18 llvm-profdata-17 llvm-profdata-16)
+    if(NOT LLVM_PROFDATA)
+        message(FATAL_ERROR "llvm-profdata is required to merge Clang profiles")
+    endif()
+    file(GLOB raw_profiles ${PROFILE_DIR}/*.profraw)
+    if(NOT raw_profiles)
+        message(FATAL_ERROR "The training run wrote no .profraw files to ${PROFILE_DIR}")
+    endif()
+    execute_process(COMMAND ${LLVM_PROFDATA} merge -output=${PROFILE_DIR}/merged.profdata ${raw_profiles}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Merging the Clang profiles failed")
+    endif()
+else()
+    file(GLOB gcda_profiles ${PROFILE_DIR}/*.gcda)
+    if(NOT gcda_profiles)
+        message(FATAL_ERROR "The training run wrote no .gcda files to ${PROFILE_DIR}")
+    endif()
+    list(LENGTH gcda_profiles gcda_count)
+    message(STATUS "  ${gcda_count} profiles in ${PROFILE_DIR}")
+endif()
+
+message(STATUS "PGO: optimized build")
+build_variant(optimized -DSUBWAY_PGO=USE)
+run_bench(${WORK_DIR}/optimized/subway_cli 2 pgo_qps)
+format_speedup(${pgo_qps} ${baseline_qps} pgo_speedup)
+
+set(bolt_line "")
+if(BOLT)
+    find_program(PERF perf)
+    find_program(PERF2BOLT perf2bolt)
+    find_program(LLVM_BOLT llvm-bolt)
+    if(PERF AND PERF2BOLT AND LLVM_BOLT)
+        message(STATUS "PGO: BOLT layout of the optimized build")
+        build_variant(bolt -DSUBWAY_PGO=USE -DSUBWAY_EMIT_RELOCS=ON)
+        set(exe ${WORK_DIR}/bolt/subway_cli)
+        execute_process(COMMAND ${PERF} record -e cycles:u -j any,u -o ${WORK_DIR}/perf.data
+                                -- ${exe} --bench ${BENCH_ARGS} 1 OUTPUT_QUIET ERROR_QUIET)
+        execute_process(COMMAND ${PERF2BOLT} -p ${WORK_DIR}/perf.data -o ${WORK_DIR}/perf.fdata ${exe}
+                        OUTPUT_QUIET)
+        execute_process(COMMAND ${LLVM_BOLT} ${exe} -o ${exe}.bolt -data=${WORK_DIR}/perf.fdata
+                                -reorder-blocks=ext-tsp -reorder-functions=hfsort -split-functions
+                                -split-all-cold -dyno-stats
+                        RESULT_VARIABLE result OUTPUT_QUIET)
+        if(result EQUAL 0)
+            run_bench(${exe}.bolt 2 bolt_qps)
+            format_speedup(${bolt_qps} ${baseline_qps} bolt_speedup)
+            set(bolt_line "\n  PGO + BOLT: ${bolt_qps} queries/s (${bolt_speedup})")
+        else()
+            message(WARNING "llvm-bolt failed; skipping the BOLT variant")
+        endif()
+    else()
+        message(WARNING "perf, perf2bolt and llvm-bolt are needed for the BOLT step; skipping it")
+    endif()
+endif()
+
+message(STATUS "PGO results (benchmark: --bench ${BENCH_LABEL}, evaluation seed 2):\n"
+               "  baseline:   ${baseline_qps} queries/s\n"
+               "  PGO:        ${pgo_qps} queries/s (${pgo_speedup})${bolt_line}\n"
+               "  optimized binary: ${WORK_DIR}/optimized/subway_cli")
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "subway/graph.h"
+#include "subway/path.h"
+
+namespace subway {
+
+// Arc flags over a view: stations are split into at most 64 regions, and bit r of
+// an edge's flags is set when the edge lies on the path Graph::dijkstra takes from
+// some station to some station of region r.
+struct ArcFlags {
+    int regionCount = 0;
+    std::vector<int> region;     // by station ID
+    std::vector<uint64_t> flags; // indexed like view.edges
+};
+
+// Splits the stations of 'view' into 'regions' connected regions grown by
+// breadth-first search from seeds picked farthest-first.
+std::vector<int> partitionStations(const GraphView &view, int regions);
+
+// Computes the flags for 'regions' regions (1-64). The search keeps one label per
+// station, so its paths depend on the source and cannot be recovered from backward
+// searches at region boundaries; the flags are instead collected from the search
+// tree of every station, then checked by repeating the restricted search from every
+// station until it reproduces those trees. Sources are processed in parallel on
+// 'threads' threads.
+ArcFlags buildArcFlags(const GraphView &view, int transferCost, int regions, int threads);
+
+// findPath restricted to edges flagged for the region of 'destination'. Returns the
+// same path as findPath on the view the flags were built for.
+PackedPath findPathArcFlags(const GraphView &view, const ArcFlags &arcFlags, int source, int destination,
+                            int transferCost);
+
+} // namespace subway
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "subway/demand.h"
+#include "subway/graph.h"
+
+namespace subway {
+
+enum AssignmentMethod {
+    ASSIGN_MSA,         // method of successive averages: step 1/k
+    ASSIGN_FRANK_WOLFE, // step chosen by line search on the Beckmann objective
+};
+
+// Result of a traffic assignment; vectors are indexed like view.edges.
+struct AssignmentResult {
+    std::vector<double> flow;
+    std::vector<double> cost; // congested cost at the final flows
+    int iterations = 0;
+    double relativeGap = 0; // (current cost - all-or-nothing cost) / current cost
+};
+
+// Adds 'value' to an atomic double (no fetch_add for floating point before C++20).
+inline void atomicAdd(std::atomic<double> &target, double value) {
+    double old = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(old, old + value, std::memory_order_relaxed)) {
+    }
+}
+
+// BPR link performance function: free-flow cost grows with (flow / capacity)^4.
+inline double congestedCost(double freeCost, double flow, double capacity) {
+    double ratio = flow / capacity;
+    return freeCost * (1.0 + 0.15 * ratio * ratio * ratio * ratio);
+}
+
+// Iterative user-equilibrium assignment with load-dependent (BPR) costs.
+// 'capacity' is indexed like view.edges. Search costs are scaled by 100 so that
+// congestion increments survive the integer shortest-path search.
+AssignmentResult assignTraffic(const GraphView &view, std::vector<OdDemand> demand, int transferCost,
+                               const std::vector<double> &capacity, AssignmentMethod method,
+                               int maxIterations, double targetGap, int threads);
+
+} // namespace subway
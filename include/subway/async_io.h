@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace subway {
+
+// File with asynchronous positional reads and writes. On Linux the requests go
+// through an io_uring submission ring; where io_uring is unavailable (old kernel,
+// seccomp, or SUBWAY_NO_URING set in the environment) each request is performed
+// with pread/pwrite when submitted and its completion is queued, so callers are
+// written once against the submit/wait interface.
+class AsyncFile {
+public:
+    AsyncFile();
+    ~AsyncFile();
+    AsyncFile(const AsyncFile &) = delete;
+    AsyncFile &operator=(const AsyncFile &) = delete;
+
+    bool open(const std::string &path, bool write, std::string &error);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    int descriptor() const { return fd; }
+    bool usingUring() const { return ring != nullptr; }
+
+    // Queues a transfer of 'size' bytes at 'offset'; 'buffer' must stay valid
+    // until the request completes. 'tag' identifies the request in wait().
+    bool submitRead(void *buffer, size_t size, uint64_t offset, int tag);
+    bool submitWrite(const void *buffer, size_t size, uint64_t offset, int tag);
+
+    // Waits for one request to complete. 'result' is the byte count, or -errno.
+    // Returns false when no request is in flight.
+    bool wait(int &tag, long long &result);
+
+    size_t inFlight() const { return pending; }
+
+private:
+    struct Uring;
+    struct Completion {
+        int tag;
+        long long result;
+    };
+
+    bool submit(bool write, void *buffer, size_t size, uint64_t offset, int tag);
+
+    int fd = -1;
+    std::unique_ptr<Uring> ring;
+    std::deque<Completion> completed; // fallback completions
+    size_t pending = 0;
+};
+
+// Sequential reader with two large buffers: while the caller consumes one chunk,
+// the read of the next one is already in flight.
+class ChunkReader {
+public:
+    explicit ChunkReader(size_t chunkBytes = 4 << 20);
+
+    bool open(const std::string &path, std::string &error);
+    void close();
+    bool usingUring() const { return file.usingUring(); }
+
+    // Hands out the next chunk, valid until the following call. Returns false at
+    // end of file or on error; 'error' is empty at a clean end of file.
+    bool next(const uint8_t *&data, size_t &size, std::string &error);
+
+private:
+    AsyncFile file;
+    std::vector<uint8_t> buffers[2];
+    uint64_t fileSize = 0;
+    uint64_t readOffset = 0; // end of the data received so far
+    bool done = false;
+};
+
+// Sequential writer with two large buffers: one fills while the other is being
+// written, so the producer only waits when the disk falls a full buffer behind.
+class ChunkWriter {
+public:
+    explicit ChunkWriter(size_t chunkBytes = 4 << 20);
+    ~ChunkWriter();
+
+    bool open(const std::string &path, std::string &error);
+    bool write(const void *data, size_t size, std::string &error);
+    // Flushes the buffers and closes the file.
+    bool close(std::string &error);
+    bool isOpen() const { return file.isOpen(); }
+    // Whether the last opened file was written through io_uring; still valid after close().
+    bool usingUring() const { return uring; }
+    uint64_t bytesWritten() const { return written; }
+
+private:
+    bool flush(std::string &error);
+    bool waitWrite(std::string &error);
+
+    AsyncFile file;
+    std::vector<uint8_t> buffers[2];
+    size_t chunkBytes;
+    int current = 0;
+    size_t expected = 0;         // size of the write in flight, if any
+    uint64_t inFlightOffset = 0; // file offset of the write in flight
+    uint64_t written = 0;
+    bool uring = false;
+};
+
+} // namespace subway
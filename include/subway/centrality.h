@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include "subway/graph.h"
+
+namespace subway {
+
+// Line-aware expansion of a view: one node per (station, arrival line), plus a
+// start node per station with no line. Moving between nodes costs the edge cost
+// plus the transfer cost when the line changes, matching Graph::dijkstra.
+struct LineGraph {
+    std::vector<int> station;   // station of each node
+    std::vector<int> startNode; // by station ID
+    std::vector<int> offsets;   // CSR over nodes
+    std::vector<int> from;
+    std::vector<int> to;
+    std::vector<int> cost;
+    std::vector<int> viewEdge; // position in view.edges of each expanded edge
+};
+
+LineGraph buildLineGraph(const GraphView &view, int transferCost);
+
+// Betweenness scores: the number of shortest station-to-station paths through each
+// station (as an intermediate stop) and each segment. Ties are split evenly.
+struct Centrality {
+    std::vector<double> station; // by station ID
+    std::vector<double> edge;    // indexed like view.edges
+};
+
+// Brandes' algorithm over the line-aware graph. Sources are processed in parallel,
+// each worker summing into its own accumulators. With 'samples' > 0 only that many
+// random sources are used and the scores are scaled up accordingly.
+Centrality betweennessCentrality(const GraphView &view, int transferCost, int samples,
+                                 unsigned seed, int threads);
+
+} // namespace subway
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "subway/demand.h"
+#include "subway/graph.h"
+
+namespace subway {
+
+// Impact of closing one segment (both directions of a line between two stations).
+struct ClosureImpact {
+    std::vector<int> edges;   // closed positions in view.edges
+    double extraCost = 0;     // increase in demand-weighted trip cost over trips still served
+    double affectedTrips = 0; // trips whose cost changed or that lost their path
+    double unservedTrips = 0; // trips left without any path
+    int researchedOrigins = 0;
+};
+
+// Groups the edges of a view into segments: an edge and its reverse on the same line.
+std::vector<std::vector<int>> viewSegments(const GraphView &view);
+
+// Evaluates closing each segment in turn. Baseline trees are grown once per origin;
+// a closure only re-searches the origins whose baseline tree contains one of the
+// closed edges. Labels only ever improve strictly, so an edge that is no station's
+// final parent never decides anything and removing it leaves the tree as it was:
+// results equal a full recompute. Closures run in parallel.
+std::vector<ClosureImpact> simulateClosures(const GraphView &view, std::vector<OdDemand> demand,
+                                            int transferCost, int threads);
+
+} // namespace subway
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+namespace subway {
+
+// ANSI color codes for different subway lines.
+std::string getColor(const std::string &line);
+
+// Reset color.
+extern const std::string reset;
+
+} // namespace subway
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace subway {
+
+// Arithmetic for route costs. The largest value doubles as "unreachable" and
+// additions saturate there instead of overflowing.
+template <class Cost>
+struct CostTraits {
+    static constexpr Cost infinity() { return std::numeric_limits<Cost>::max(); }
+    static constexpr Cost zero() { return Cost(0); }
+    // Saturating a + b for non-negative b.
+    static constexpr Cost add(Cost a, Cost b) { return a > infinity() - b ? infinity() : Cost(a + b); }
+    static constexpr Cost fromInt(long long v) { return v >= (long long)infinity() ? infinity() : Cost(v); }
+    static constexpr double toDouble(Cost c) { return (double)c; }
+};
+
+// Unsigned 16.16 fixed-point cost, for fractional weights without floating point.
+struct FixedCost {
+    uint32_t raw;
+    constexpr bool operator<(FixedCost o) const { return raw < o.raw; }
+    constexpr bool operator>(FixedCost o) const { return raw > o.raw; }
+    constexpr bool operator==(FixedCost o) const { return raw == o.raw; }
+    constexpr bool operator!=(FixedCost o) const { return raw != o.raw; }
+};
+
+template <>
+struct CostTraits<FixedCost> {
+    static constexpr FixedCost infinity() { return {std::numeric_limits<uint32_t>::max()}; }
+    static constexpr FixedCost zero() { return {0}; }
+    static constexpr FixedCost add(FixedCost a, FixedCost b) {
+        return a.raw > infinity().raw - b.raw ? infinity() : FixedCost{a.raw + b.raw};
+    }
+    static constexpr FixedCost fromInt(long long v) {
+        return v >= (long long)(infinity().raw >> 16) ? infinity() : FixedCost{(uint32_t)(v << 16)};
+    }
+    static constexpr double toDouble(FixedCost c) { return c.raw / 65536.0; }
+};
+
+} // namespace subway
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "subway/async_io.h"
+#include "subway/graph.h"
+
+namespace subway {
+
+// Trips from one station to another.
+struct OdDemand {
+    int origin;
+    int destination;
+    double trips;
+};
+
+// Loads an origin-destination demand matrix, keeping only pairs with demand > 0.
+// Supported formats:
+//   binary   "ODM1" magic, uint32 layout (0 = dense, 1 = sparse), uint32 station count,
+//            then float32[count * count] (dense, row = origin) or uint64 record count
+//            followed by {uint32 origin, uint32 destination, float32 trips} (sparse).
+//            Station IDs are Graph station IDs.
+//   CSV      sparse: header "origin,destination,trips", one pair per line;
+//            dense: header ",<dest 1>,<dest 2>,...", rows "<origin>,<trips>,...".
+//            Stations are given by name or by numeric ID.
+// Returns false and sets 'error' when the file cannot be read.
+bool loadOdMatrix(const std::string &path, const Graph &graph, std::vector<OdDemand> &demand, std::string &error);
+
+// Streams a sparse binary ("ODM1", layout 1) matrix in chunks instead of loading
+// it whole. The file is read ahead by a ChunkReader, so the disk read of the next
+// chunk overlaps with routing the current one.
+class OdStream {
+public:
+    bool open(const std::string &path, const Graph &graph, std::string &error);
+
+    // Replaces 'out' with up to 'maxRecords' pairs with demand > 0. Returns false
+    // once the matrix is exhausted, or on error with 'error' set.
+    bool next(std::vector<OdDemand> &out, size_t maxRecords, std::string &error);
+
+    bool usingUring() const { return reader.usingUring(); }
+
+private:
+    ChunkReader reader;
+    const uint8_t *data = nullptr;
+    size_t size = 0, pos = 0;
+    std::vector<uint8_t> carry; // record split across two chunks
+    uint64_t remaining = 0;
+    uint32_t stations = 0;
+};
+
+// Passenger loads from routing every OD pair once on the free-flow costs.
+struct FlowReport {
+    std::vector<double> edgeFlow;  // passengers per segment, indexed like view.edges
+    std::vector<double> transfers; // passengers changing lines, by the station boarded at
+    std::vector<double> boardings; // passengers boarding, by line ID
+    double unrouted = 0;           // trips with no path
+};
+
+// Routes every OD pair in parallel. Each worker accumulates into its own buffers,
+// which are summed once all origins are done, so the hot loop has no shared writes.
+// Legs on 'walkingLine' (-1 = none) are not counted as boardings, and a walk between
+// two lines is one transfer, not one at each end; pairs whose origin is their
+// destination are skipped.
+FlowReport aggregateFlows(const GraphView &view, std::vector<OdDemand> demand, int transferCost,
+                          size_t lineCount, int walkingLine, int threads);
+
+} // namespace subway
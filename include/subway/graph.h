@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "subway/perfect_hash.h"
+
+namespace subway {
+
+// Represents a connection from one station to another.
+struct Edge {
+    std::string destination;
+    int cost;
+    std::string line;   // subway line (e.g., "1", "2", "3")
+    int lineId;         // dense index of 'line' in Graph::lineNames
+    int id;             // global edge ID, in insertion order
+    uint8_t attributes; // AttributeFlags of this connection
+};
+
+// Attribute flags for stations and edges. A graph view built for a mask leaves
+// out every station and edge carrying any of the mask's flags.
+enum AttributeFlags : uint8_t {
+    ATTR_INACCESSIBLE = 1,       // no step-free access (station) or stairs-only transfer (edge)
+    ATTR_UNDER_CONSTRUCTION = 2, // closed for works
+    ATTR_WEEKEND_ONLY = 4,       // only open on weekends
+};
+
+// Edge of a graph view; stations are referred to by ID.
+struct ViewEdge {
+    int destination;
+    int cost;
+    int lineId;
+    int edgeId; // global edge ID of the underlying Edge
+};
+
+// Compressed adjacency (CSR) of the graph with all stations and edges
+// matching 'mask' filtered out. Edges of station s are
+// edges[offsets[s] .. offsets[s + 1]); the positions of the edges entering s are
+// reverseEdges[reverseOffsets[s] .. reverseOffsets[s + 1]).
+struct GraphView {
+    uint8_t mask = 0;
+    std::vector<int> offsets;
+    std::vector<ViewEdge> edges;
+    std::vector<int> reverseOffsets;
+    std::vector<int> reverseEdges;
+};
+
+// Fare rules used by the fare-aware search.
+// Per-line data is stored in vectors indexed by line ID so that a fare lookup
+// during the search is a single array access.
+struct FareModel {
+    int baseFare = 290;         // flat fare (cents) paid when boarding outside a transfer window
+    int transferWindow = 120;   // cost units after paying during which boardings are free
+    std::vector<int> surcharge; // premium/express surcharge per boarding, by line ID
+    std::vector<char> walking;  // 1 if the line is a walking link (no boarding, no fare)
+};
+
+// From 'start' (minutes after midnight) until the next band, a line runs every
+// 'headway' minutes; headway 0 means no service.
+struct HeadwayBand {
+    uint16_t start;
+    uint16_t headway;
+};
+
+// Frequency-based service for lines without a published timetable, used by the
+// findPath/findRoute overloads that take one. The bands of line l are
+// bands[bandOffsets[l] .. bandOffsets[l + 1]), sorted by start; the last band of the
+// day also covers the hours before the first. Lines without bands (walking links)
+// are boarded without waiting.
+struct FrequencyModel {
+    std::vector<int> bandOffsets; // by line ID
+    std::vector<HeadwayBand> bands;
+
+    // Replaces the bands of a line.
+    void setBands(int lineId, const std::vector<HeadwayBand> &lineBands);
+
+    // Headway of 'lineId' at 'time' (minutes, taken modulo a day, so negative times
+    // fall on the previous day); -1 without bands.
+    int headway(int lineId, int time) const;
+
+    // Expected wait on boarding 'lineId' at 'time', half a headway rounded up as
+    // passengers turn up at random; 0 for walking links, and the largest int when
+    // the line is not running.
+    int expectedWait(int lineId, int time) const;
+};
+
+// One Pareto-optimal result of the fare-aware search.
+struct FareRoute {
+    int time; // total cost including transfer penalties
+    int fare; // total fare in cents
+    std::vector<std::pair<std::string, std::string>> path; // {station, line used to reach it}
+};
+
+// Graph class representing the subway system.
+class Graph {
+public:
+    // Adjacency list: station name -> list of edges.
+    std::unordered_map<std::string, std::vector<Edge>> adjList;
+    // Line name <-> dense line ID.
+    std::vector<std::string> lineNames;
+    std::unordered_map<std::string, int> lineIds;
+    // Station name <-> dense station ID.
+    std::vector<std::string> stationNames;
+    std::unordered_map<std::string, int> stationIds;
+    std::vector<uint8_t> stationAttributes; // AttributeFlags by station ID
+    // Minimal perfect hash indexes over the station and line names, built by
+    // finalize() once the name sets are complete. Registering a new name drops
+    // them until the next finalize().
+    NameIndex stationIndex;
+    NameIndex lineIndex;
+    int edgeCount = 0;
+    // Precomputed filtered views, keyed by attribute mask.
+    std::unordered_map<uint8_t, GraphView> views;
+
+    // Returns the ID of 'station', registering it on first use.
+    int internStation(const std::string &station);
+
+    // Returns the ID of 'line', registering it on first use.
+    int internLine(const std::string &line);
+
+    // Builds the perfect hash name indexes. Call after the last station and line
+    // have been added; lookups fall back to the hash maps until then.
+    void finalize();
+
+    // Returns the ID of a station or line, or -1 if there is none with that name.
+    int findStation(std::string_view name) const;
+    int findLine(std::string_view name) const;
+
+    // Add a directed edge from 'from' to 'to'.
+    void addEdge(const std::string &from, const std::string &to, int cost, const std::string &line);
+
+    // Sets the attribute flags of a station.
+    void setStationAttributes(const std::string &station, uint8_t flags);
+
+    // Sets the attribute flags of every edge between s1 and s2 on 'line', in both directions.
+    void setSegmentAttributes(const std::string &s1, const std::string &s2, const std::string &line, uint8_t flags);
+
+    // Builds the CSR view that excludes stations and edges matching 'mask'.
+    GraphView buildView(uint8_t mask) const;
+
+    // Precomputes the views for the given masks so that queries never filter edges.
+    // Views are dropped whenever the graph or its attributes change.
+    void prepareViews(const std::vector<uint8_t> &masks);
+
+    // Returns the view for 'mask', building it on first use.
+    const GraphView &view(uint8_t mask);
+
+    // Add a bidirectional edge.
+    void addBidirectionalEdge(const std::string &s1, const std::string &s2, int cost, const std::string &line);
+
+    // Finds the minimum-cost path from source to destination using Dijkstra's algorithm.
+    // A transfer (switching subway lines) incurs an extra transferCost if the traveling line changes.
+    // Returns a pair: {total cost, vector of {station, line used to reach it}}.
+    std::pair<int, std::vector<std::pair<std::string, std::string>>> dijkstra(const std::string &source, const std::string &destination, int transferCost);
+
+    // Same search as above, run over a precomputed view. Stations and edges left
+    // out of the view are never visited, and switching views costs nothing.
+    // 'prefetchDistance' is passed to findPath (0 disables software prefetching).
+    std::pair<int, std::vector<std::pair<std::string, std::string>>> dijkstra(const std::string &source, const std::string &destination,
+                                                                              int transferCost, const GraphView &view,
+                                                                              int prefetchDistance = 0);
+
+    // Creates a fare model sized for the current lines, with no surcharges.
+    // The "Interchange" line is treated as a walking link.
+    FareModel makeFareModel(int baseFare, int transferWindow) const;
+
+    // Creates a frequency model sized for the current lines, every line running every
+    // 'headway' minutes all day. The "Interchange" line gets no bands (no waiting).
+    FrequencyModel makeFrequencyModel(int headway) const;
+
+    // Finds all routes that are Pareto-optimal in (time, fare).
+    // Time follows the same rules as dijkstra(). A fare is charged when boarding a
+    // non-walking line unless the last fare was paid less than transferWindow ago;
+    // premium lines add their surcharge on every boarding.
+    // Routes are returned in increasing time (and therefore decreasing fare).
+    std::vector<FareRoute> fareAwareRoutes(const std::string &source, const std::string &destination,
+                                           int transferCost, const FareModel &fares, const GraphView &view);
+
+    // Display the subway map in a neatly formatted style.
+    void displayMap();
+};
+
+} // namespace subway
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+#include "subway/graph.h"
+#include "subway/trip_based.h"
+
+namespace subway {
+
+// Binary graph file ("SGF1"): the station and line registries, station attributes,
+// every edge in edge ID order, and the finalized perfect hash name indexes, so a
+// loaded graph resolves names without rebuilding them. Layout (native endianness):
+//   "SGF1", uint32 version
+//   uint32 station count, per station {uint32 length, bytes}, uint8 attributes[count]
+//   uint32 line count, per line {uint32 length, bytes}
+//   uint32 edge count, per edge {uint32 from, uint32 to, uint32 line, int32 cost, uint32 attributes}
+//   station index, line index: uint64 seed, uint64 slots, uint32 pilot count,
+//     uint32 pilots[], uint32 ids[slots], uint32 offsets[slots + 1], uint32 arena bytes, arena
+//   uint32 has Trip-Based section (version 2), then int32 transfer time and each
+//     timetable and transfer array of TripBased in declaration order as {uint32 count, entries}
+// The graph is finalized before it is written; 'tripBased' is optional.
+bool saveGraph(Graph &graph, const std::string &path, std::string &error, const TripBased *tripBased = nullptr);
+
+// Replaces 'graph' with the contents of a file written by saveGraph. When given,
+// 'tripBased' receives the Trip-Based section, or is left empty if the file has none.
+bool loadGraph(Graph &graph, const std::string &path, std::string &error, TripBased *tripBased = nullptr);
+
+} // namespace subway
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "subway/graph.h"
+
+namespace subway {
+
+// True when the library was built with C++20 coroutines; otherwise
+// interleavedCosts always runs the plain loop.
+bool interleavingAvailable();
+
+// Costs of point-to-point queries over 'view' (-1 when unreachable), with the
+// transfer rules and results of findPath. With group > 1, 'group' queries run at
+// once as coroutines: each issues prefetches for the edge range of the station it
+// settles and for the distance entries of that station's neighbours, then
+// suspends so another query runs while the cache lines arrive. group <= 1 runs
+// the same search as a plain loop, one query after another.
+std::vector<int> interleavedCosts(const GraphView &view, const std::vector<std::pair<int, int>> &queries,
+                                  int transferCost, int group);
+
+} // namespace subway
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "subway/cost.h"
+#include "subway/graph.h"
+
+namespace subway {
+
+// Queue policy: binary heap, for any cost type.
+template <class Cost, class Id>
+class HeapQueue {
+public:
+    explicit HeapQueue(Cost) {}
+    bool empty() const { return heap.empty(); }
+    void clear() { heap.clear(); }
+    void push(Cost cost, Id id) {
+        heap.push_back({cost, id});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+    std::pair<Cost, Id> pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        Entry top = heap.back();
+        heap.pop_back();
+        return {top.cost, top.id};
+    }
+
+private:
+    struct Entry {
+        Cost cost;
+        Id id;
+        // Ties go to the lower ID, as in the station queue of findPath.
+        bool operator>(const Entry &o) const { return cost > o.cost || (cost == o.cost && id > o.id); }
+    };
+    std::vector<Entry> heap;
+};
+
+// Queue policy: Dial's circular bucket queue, for integral costs whose largest
+// single step (edge plus transfer cost) is small. Each bucket is sorted once when
+// it is reached, so ties go to the lower ID like the heap.
+template <class Cost, class Id>
+class BucketQueue {
+    static_assert(std::is_integral<Cost>::value, "bucket queues need integral costs");
+
+public:
+    explicit BucketQueue(Cost maxStep) : buckets((size_t)maxStep + 1) {}
+    bool empty() const { return size == 0; }
+    void clear() {
+        for (auto &b : buckets) b.clear();
+        size = 0;
+        started = false;
+        sorted = false;
+    }
+    void push(Cost cost, Id id) {
+        // Entries never go below the cost being settled, so 'current' only moves forward.
+        if (!started) {
+            current = cost;
+            started = true;
+        }
+        if (cost == current) sorted = false;
+        buckets[(size_t)cost % buckets.size()].push_back(id);
+        size++;
+    }
+    std::pair<Cost, Id> pop() {
+        while (buckets[(size_t)current % buckets.size()].empty()) {
+            current++;
+            sorted = false;
+        }
+        auto &bucket = buckets[(size_t)current % buckets.size()];
+        if (!sorted) {
+            std::sort(bucket.begin(), bucket.end(), std::greater<Id>());
+            sorted = true;
+        }
+        Id id = bucket.back();
+        bucket.pop_back();
+        size--;
+        return {current, id};
+    }
+
+private:
+    std::vector<std::vector<Id>> buckets;
+    size_t size = 0;
+    Cost current = 0;
+    bool started = false;
+    bool sorted = false;
+};
+
+// Routing core specialized for a cost type, a station/edge ID width and a queue
+// policy. The view is copied into arrays of exactly those widths, so a small
+// network with 16-bit costs and IDs moves half the bytes of the int version.
+// Costs saturate at CostTraits<Cost>::infinity(), which also means unreachable.
+template <class Cost, class Id, template <class, class> class Queue>
+class RoutingKernel {
+public:
+    typedef CostTraits<Cost> Traits;
+
+    // True if the view's stations, edges, lines and costs fit this instantiation.
+    static bool fits(const GraphView &view, int transferCost) {
+        size_t limit = (size_t)std::numeric_limits<Id>::max();
+        if (view.offsets.size() > limit || view.edges.size() > limit) return false;
+        for (const auto &edge : view.edges) {
+            if ((size_t)edge.lineId >= limit) return false;
+            if (Traits::fromInt((long long)edge.cost + transferCost) == Traits::infinity()) return false;
+        }
+        return true;
+    }
+
+    RoutingKernel(const GraphView &view, int transferCost)
+        : transfer(Traits::fromInt(transferCost)), queue(maxStep(view, transferCost)) {
+        offsets.assign(view.offsets.begin(), view.offsets.end());
+        for (const auto &edge : view.edges) {
+            destination.push_back((Id)edge.destination);
+            cost.push_back(Traits::fromInt(edge.cost));
+            line.push_back((Id)edge.lineId);
+        }
+        size_t n = offsets.size() - 1;
+        dist.assign(n, Traits::infinity());
+        arrival.assign(n, noLine);
+    }
+
+    // Cost from source to destination, or infinity if unreachable.
+    Cost route(Id source, Id target) {
+        for (Id s : touched) {
+            dist[s] = Traits::infinity();
+            arrival[s] = noLine;
+        }
+        touched.clear();
+        queue.clear();
+        dist[source] = Traits::zero();
+        touched.push_back(source);
+        queue.push(Traits::zero(), source);
+        while (!queue.empty()) {
+            auto [d, u] = queue.pop();
+            if (d > dist[u]) continue;
+            if (u == target) break;
+            for (size_t e = offsets[u]; e < (size_t)offsets[u + 1]; e++) {
+                Cost step = cost[e];
+                if (arrival[u] != noLine && arrival[u] != line[e]) step = Traits::add(step, transfer);
+                Cost newCost = Traits::add(d, step);
+                Id v = destination[e];
+                if (newCost < dist[v]) {
+                    if (dist[v] == Traits::infinity()) touched.push_back(v);
+                    dist[v] = newCost;
+                    arrival[v] = line[e];
+                    queue.push(newCost, v);
+                }
+            }
+        }
+        return dist[target];
+    }
+
+    // Bytes of graph and per-query state touched by route().
+    size_t memoryBytes() const {
+        return offsets.size() * sizeof(Id) + destination.size() * sizeof(Id) + cost.size() * sizeof(Cost) +
+               line.size() * sizeof(Id) + dist.size() * sizeof(Cost) + arrival.size() * sizeof(Id);
+    }
+
+private:
+    static constexpr Id noLine = std::numeric_limits<Id>::max();
+
+    static Cost maxStep(const GraphView &view, int transferCost) {
+        int step = 0;
+        for (const auto &edge : view.edges) step = std::max(step, edge.cost);
+        return Traits::fromInt((long long)step + transferCost);
+    }
+
+    std::vector<Id> offsets;
+    std::vector<Id> destination;
+    std::vector<Cost> cost;
+    std::vector<Id> line;
+    Cost transfer;
+    std::vector<Cost> dist;
+    std::vector<Id> arrival;
+    std::vector<Id> touched;
+    Queue<Cost, Id> queue;
+};
+
+} // namespace subway
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace subway {
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov's ring of
+// sequenced cells). Capacity is rounded up to a power of two. tryPush and tryPop
+// never block; callers decide how to wait when the queue is full or empty.
+template <class T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        cells = std::vector<Cell>(size);
+        for (size_t i = 0; i < size; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+        mask = size - 1;
+    }
+
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    bool tryPush(T &&value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < pos) {
+                return false; // full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T &value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (seq == pos + 1) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < pos + 1) {
+                return false; // empty
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+        Cell() = default;
+        Cell(Cell &&other) noexcept : sequence(other.sequence.load()), value(std::move(other.value)) {}
+    };
+
+    std::vector<Cell> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+} // namespace subway
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "subway/graph.h"
+#include "subway/search_tree.h"
+
+namespace subway {
+
+// WGS84 coordinate in millionths of a degree.
+struct ShapePoint {
+    int32_t lat;
+    int32_t lon;
+};
+
+// Polyline geometry of edges, keyed by global edge ID. All points live in one
+// array; an edge refers to a run of it, and the two directions of a segment
+// share one run, the reverse direction reading it backwards.
+class ShapeStore {
+public:
+    // Stores the polyline of 'edgeId' in its direction of travel.
+    void setShape(int edgeId, const std::vector<ShapePoint> &points);
+
+    // Makes 'edgeId' use the shape of 'other', traversed in the opposite direction.
+    void shareReversed(int edgeId, int other);
+
+    bool hasShape(int edgeId) const;
+
+    // Appends the polyline of 'edgeId' to 'out'. The first point is skipped when
+    // it equals the last point already in 'out', so consecutive edges join up.
+    void appendShape(int edgeId, std::vector<ShapePoint> &out) const;
+
+    size_t memoryBytes() const { return runs.size() * sizeof(Run) + points.size() * sizeof(ShapePoint); }
+
+private:
+    struct Run {
+        uint32_t offset = 0;
+        uint32_t count : 31;
+        uint32_t reversed : 1;
+        Run() : count(0), reversed(0) {}
+    };
+
+    std::vector<Run> runs; // by edge ID; count 0 means no shape
+    std::vector<ShapePoint> points;
+};
+
+// Builds straight-line shapes between station coordinates (indexed by station ID)
+// for every edge of the graph, one shared run per segment.
+ShapeStore buildStationShapes(const Graph &graph, const std::vector<ShapePoint> &stationCoords);
+
+// Result of a point-to-point search in packed form: the positions in view.edges
+// of the edges taken, in travel order. Callers that only need the cost never unpack it.
+struct PackedPath {
+    int cost = -1; // -1 when the destination is unreachable
+    int source = -1;
+    std::vector<int> edges;
+    std::vector<int> waits; // expected wait at each boarding, frequency-based paths only
+};
+
+// One ride on a single line, unpacked from a PackedPath.
+struct PathLeg {
+    int lineId = -1;
+    int transferPenalty = 0;          // penalty paid on boarding (0 for the first leg)
+    int wait = 0;                     // expected wait on boarding, frequency-based paths only
+    std::vector<int> stations;        // boarding station first, alighting station last
+    std::vector<int> edgeIds;         // global edge ID of each segment
+    std::vector<int> segmentCosts;    // cost of each segment, without the penalty
+    std::vector<int> cumulativeCosts; // cost from the source on reaching stations[i]
+    std::vector<ShapePoint> geometry; // polyline of the leg, only filled when shapes are given
+};
+
+// Summary of one ride on a single line.
+struct RouteLeg {
+    int board;  // station ID
+    int alight; // station ID
+    int lineId;
+    int stops;  // segments ridden
+    int cost;   // cost of the leg, including the transfer penalty (and expected wait) paid on boarding
+};
+
+// Leg-level result of a point-to-point search: a few words per line ridden
+// instead of a name pair per station. Leg costs add up to 'cost'.
+struct Route {
+    int cost = -1; // -1 when the destination is unreachable
+    std::vector<RouteLeg> legs;
+};
+
+// Point-to-point search between station IDs over 'view', with the same transfer
+// rules as Graph::dijkstra. Stations of equal cost are settled lower ID first, so
+// among equal-cost paths the result is deterministic; Graph::dijkstra orders its
+// queue by cost only and may return a different path of the same cost. A positive 'prefetchDistance' makes the
+// relaxation loop prefetch distance entries that many edges ahead, plus the edge
+// range of the next station in the queue; results are the same either way.
+PackedPath findPath(const GraphView &view, int source, int destination, int transferCost,
+                    int prefetchDistance = 0);
+
+// Same search as findPath, summarized into legs while the path is reconstructed.
+Route findRoute(const GraphView &view, int source, int destination, int transferCost);
+
+// Searches under the frequency-based model instead of the static edge costs: every
+// boarding (the first one and each line change) also costs the expected wait for
+// that line at the clock time it happens, 'departure' plus the cost so far, so the
+// cost is the expected journey time. Labels are settled once, which is exact while
+// later boarding never means an earlier expected departure (true within a band,
+// and off by less than the drop in wait where a band gets more frequent).
+PackedPath findPath(const GraphView &view, int source, int destination, int transferCost,
+                    const FrequencyModel &frequencies, int departure);
+Route findRoute(const GraphView &view, int source, int destination, int transferCost,
+                const FrequencyModel &frequencies, int departure);
+
+// Leg summary of the path to 'destination' in a tree grown by buildSearchTree.
+Route treeRoute(const GraphView &view, const SearchTree &tree, int destination);
+
+// Expands a path found over 'view' into legs. Cumulative costs include the
+// transfer penalty and, for frequency-based paths, the expected wait paid on
+// boarding, so they end at path.cost. Geometry is gathered only when 'shapes' is
+// given; edges without a shape contribute no points.
+std::vector<PathLeg> unpackPath(const GraphView &view, const PackedPath &path, int transferCost,
+                                const ShapeStore *shapes = nullptr);
+
+} // namespace subway
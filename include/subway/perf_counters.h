@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace subway {
+
+enum PerfEvent {
+    PERF_TASK_CLOCK, // software event, nanoseconds on CPU
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+const char *perfEventName(PerfEvent event);
+
+// Counter values for one measured region. 'valid' says which events could be
+// opened; a missing hardware PMU (virtual machines, containers) or a restrictive
+// perf_event_paranoid leaves the hardware events unavailable.
+struct PerfReading {
+    bool valid[PERF_EVENT_COUNT] = {};
+    uint64_t value[PERF_EVENT_COUNT] = {};
+};
+
+// Hardware and software counters for the calling thread, read through
+// perf_event_open on Linux. Each event is opened on its own so that whatever the
+// machine supports is still counted; elsewhere nothing opens and readings are empty.
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    // Opens every event the system allows. Returns false with 'error' set when none
+    // could be opened.
+    bool open(std::string &error);
+    void close();
+    bool available(PerfEvent event) const { return fds[event] >= 0; }
+
+    // Resets and enables the counters; stop() disables them and reads the values.
+    void start();
+    PerfReading stop();
+
+private:
+    int fds[PERF_EVENT_COUNT] = {-1, -1, -1, -1, -1, -1};
+};
+
+} // namespace subway
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace subway {
+
+// 64-bit MurmurHash64A of 'key'.
+uint64_t hashName(std::string_view key, uint64_t seed);
+
+// Minimal perfect hash over a fixed key set, in the style of PTHash: keys are
+// split into buckets, and each bucket gets a "pilot" chosen at build time so
+// that all its keys land in free slots. Lookup is one hash, one pilot read and
+// one modulo; n keys map onto slots 0..n-1 without collisions. Keys outside the
+// set map to an arbitrary slot, so callers verify the key (see NameIndex).
+class PerfectHash {
+public:
+    // Builds the function for distinct 'keys'. Returns false if the keys are not distinct.
+    bool build(const std::vector<std::string_view> &keys);
+
+    // Slot of 'key', or noSlot when the set is empty (there is no slot to map to).
+    uint32_t operator()(std::string_view key) const {
+        if (slots == 0) return noSlot;
+        uint64_t h = hashName(key, seed);
+        uint64_t pilot = pilots[(uint32_t)(h >> 32) % (uint32_t)pilots.size()];
+        return slotOf(h, mixPilot(pilot), slots);
+    }
+
+    static constexpr uint32_t noSlot = UINT32_MAX;
+
+    size_t size() const { return slots; }
+    size_t memoryBytes() const { return pilots.size() * sizeof(uint32_t); }
+
+    uint64_t seed = 0;
+    uint64_t slots = 0;
+    std::vector<uint32_t> pilots; // one per bucket
+
+private:
+    static uint64_t mixPilot(uint64_t pilot) {
+        pilot *= 0x9e3779b97f4a7c15ULL;
+        return pilot ^ (pilot >> 29);
+    }
+
+    // The combined hash is mixed once more so that the slot depends on all of its
+    // bits: with a power-of-two slot count the plain modulo would keep only the low
+    // bits, and keys agreeing in them would collide under every pilot.
+    static uint32_t slotOf(uint64_t h, uint64_t mixed, uint64_t slots) {
+        uint64_t x = (h ^ mixed) * 0xff51afd7ed558ccdULL;
+        return (uint32_t)((x ^ (x >> 32)) % slots);
+    }
+};
+
+// Name -> ID lookup over a fixed set of names, built on a PerfectHash. The names
+// are kept in one character arena laid out by slot, so a lookup is the hash, the
+// pilot, and one comparison against contiguous memory.
+class NameIndex {
+public:
+    // Indexes names[i] -> i. Returns false if the names are not distinct.
+    bool build(const std::vector<std::string> &names);
+
+    // Returns the ID of 'name', or -1 if it is not in the set.
+    int find(std::string_view name) const {
+        if (ids.empty()) return -1;
+        uint32_t slot = hash(name);
+        std::string_view stored(arena.data() + offsets[slot], offsets[slot + 1] - offsets[slot]);
+        return stored == name ? (int)ids[slot] : -1;
+    }
+
+    size_t size() const { return ids.size(); }
+    size_t memoryBytes() const {
+        return hash.memoryBytes() + ids.size() * sizeof(uint32_t) + offsets.size() * sizeof(uint32_t) + arena.size();
+    }
+
+    PerfectHash hash;
+    std::vector<uint32_t> ids;     // by slot
+    std::vector<uint32_t> offsets; // name of slot s is arena[offsets[s] .. offsets[s + 1])
+    std::string arena;
+};
+
+} // namespace subway
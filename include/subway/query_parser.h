@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "subway/demand.h"
+#include "subway/perfect_hash.h"
+
+namespace subway {
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    bool open(const std::string &path, std::string &error);
+    void close();
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+};
+
+// Instruction sets for the separator scan.
+enum SimdLevel : uint8_t {
+    SIMD_SCALAR = 0,
+    SIMD_SSE2 = 1,
+    SIMD_AVX2 = 2,
+};
+
+// Best level supported by the running CPU.
+SimdLevel bestSimdLevel();
+const char *simdLevelName(SimdLevel level);
+
+// Appends to 'out' the offsets of every ',' and '\n' in data[0 .. size), in order.
+// The SSE2 and AVX2 versions compare 16 or 32 bytes at a time and walk the
+// resulting bit masks; all levels give the same result.
+void findSeparators(const char *data, size_t size, SimdLevel level, std::vector<uint32_t> &out);
+
+// A byte range of the input that starts and ends on line boundaries.
+struct QueryBlock {
+    size_t begin;
+    size_t end;
+};
+
+// Splits data[0 .. size) into blocks of about 'blockBytes', each ending after a newline.
+std::vector<QueryBlock> splitQueryBlocks(const char *data, size_t size, size_t blockBytes);
+
+// Parses sparse CSV queries "origin,destination[,trips]" from data[0 .. size),
+// which must start at a line start, replacing the contents of 'out'. A station
+// field of digits only is a station ID (below stations.size()); any other field is
+// a name resolved through 'stations'. Trips default to 1. Blank lines and "origin,..." header lines are skipped. The input
+// is never copied: fields are read in place between the separators found by
+// findSeparators. Returns false with 'error' set on the first malformed line.
+bool parseQueryBlock(const char *data, size_t size, const NameIndex &stations, SimdLevel level,
+                     std::vector<OdDemand> &out, std::string &error);
+
+} // namespace subway
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "subway/demand.h"
+#include "subway/graph.h"
+
+namespace subway {
+
+// One event of a delay/closure feed.
+enum FeedEventKind : uint8_t {
+    FEED_DELAY = 0,  // set the delay of an edge to 'value' cost units (0 clears it)
+    FEED_CLOSE = 1,  // close an edge
+    FEED_REOPEN = 2, // reopen a closed edge
+};
+
+struct FeedEvent {
+    uint32_t timestamp; // seconds
+    uint8_t kind;       // FeedEventKind
+    uint8_t reserved[3];
+    uint32_t edgeId; // global edge ID (Edge::id)
+    int32_t value;
+};
+
+// Loads a feed in the compact binary format: "EVT1" magic, uint32 event count,
+// then FeedEvent records sorted by timestamp.
+bool loadEventFeed(const std::string &path, std::vector<FeedEvent> &events, std::string &error);
+
+// Timings of one replayed time slice.
+struct SliceStats {
+    uint32_t start;
+    size_t events;
+    size_t changedEdges;
+    double updateMs; // applying the batch and repairing cached trees
+    double queryMs;  // answering the workload afterwards
+};
+
+// Replays a feed against a snapshot of 'view'. Events are batched per 'sliceSeconds';
+// each batch is applied to the snapshot costs, the cached tree of every workload
+// origin is repaired once per changed edge (trees in parallel), and then every
+// query of the workload is answered from the trees.
+std::vector<SliceStats> replayFeed(const GraphView &view, const std::vector<FeedEvent> &events, uint32_t sliceSeconds,
+                                   const std::vector<OdDemand> &queries, int transferCost, int threads);
+
+} // namespace subway
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "subway/async_io.h"
+#include "subway/mpmc_queue.h"
+#include "subway/path.h"
+
+namespace subway {
+
+// A block of batch routing results in columnar form. Row i is the query
+// origin[i] -> destination[i]; its legs are leg*[legOffsets[i] .. legOffsets[i + 1]).
+// Unreachable queries have cost -1 and no legs.
+struct ResultBlock {
+    std::vector<uint32_t> origin;
+    std::vector<uint32_t> destination;
+    std::vector<int32_t> cost;
+    std::vector<uint32_t> legOffsets{0};
+    std::vector<uint32_t> legBoard;
+    std::vector<uint32_t> legAlight;
+    std::vector<uint32_t> legLine;
+    std::vector<uint32_t> legStops;
+    std::vector<int32_t> legCost;
+
+    size_t rows() const { return origin.size(); }
+    void add(int from, int to, const Route &route);
+    void clear();
+};
+
+// Encodes a block as stored in a result file. Every column is delta coded with
+// zigzag varints ("codec 1"); a block that does not shrink is stored raw ("codec 0").
+//   block:  uint32 rows, uint32 legs, uint32 codec, uint32 payload bytes, payload
+//   payload: origin, destination, cost, legOffsets (rows + 1), legBoard, legAlight,
+//            legLine, legStops, legCost
+// A result file is the "RES1" magic followed by blocks until end of file.
+void encodeResultBlock(const ResultBlock &block, std::vector<uint8_t> &out);
+
+// Writes result blocks from a dedicated I/O thread. Producers (any number of
+// threads) encode their block and hand the bytes over through a lock-free queue,
+// so routing threads never wait on the disk unless the queue is full. The I/O
+// thread writes through a double-buffered ChunkWriter (io_uring where available).
+class ResultWriter {
+public:
+    explicit ResultWriter(size_t queueCapacity = 64);
+    ~ResultWriter();
+
+    bool open(const std::string &path, std::string &error);
+
+    // Encodes 'block' on the calling thread and queues it for writing. Thread-safe.
+    void submit(const ResultBlock &block);
+
+    // Drains the queue, stops the I/O thread and closes the file.
+    bool close(std::string &error);
+
+    uint64_t bytesWritten() const { return out.bytesWritten(); }
+    bool usingUring() const { return out.usingUring(); }
+
+private:
+    void ioLoop();
+
+    MpmcQueue<std::vector<uint8_t>> queue;
+    ChunkWriter out;
+    std::thread ioThread;
+    std::atomic<bool> closing{false};
+    std::string ioError; // set by the I/O thread, read after it has joined
+};
+
+// Reads a result file block by block.
+class ResultReader {
+public:
+    ~ResultReader();
+
+    bool open(const std::string &path, std::string &error);
+
+    // Decodes the next block into 'block'. Returns false at end of file or on
+    // error; 'error' is empty at a clean end of file.
+    bool next(ResultBlock &block, std::string &error);
+
+    void close();
+
+private:
+    std::FILE *file = nullptr;
+    uint64_t fileSize = 0;
+    std::vector<uint8_t> payload;
+};
+
+} // namespace subway
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include "subway/graph.h"
+#include "subway/path.h"
+#include "subway/static_network.h"
+
+namespace subway {
+
+// The sample network, described once and compiled into static arrays. Station order
+// matches the IDs Graph assigns when buildSampleGraph() inserts these segments.
+constexpr std::array<std::string_view, 10> kSampleStations = {
+    "Times Sq", "42nd St", "34th St", "Penn Station", "Grand Central",
+    "14th St", "Wall St", "Union Sq", "Houston St", "Canal St"};
+constexpr std::array<std::string_view, 4> kSampleLines = {"1", "2", "3", "Interchange"};
+constexpr std::array<StaticSegmentSpec, 10> kSampleSegments = {{
+    // Line "1"
+    {"Times Sq", "42nd St", 4, "1"},
+    {"42nd St", "34th St", 5, "1"},
+    {"34th St", "Penn Station", 6, "1"},
+
+    // Line "2"
+    {"42nd St", "Grand Central", 3, "2"},
+    {"Grand Central", "14th St", 6, "2"},
+    {"14th St", "Wall St", 7, "2"},
+
+    // Line "3"
+    {"34th St", "Union Sq", 4, "3"},
+    {"Union Sq", "Houston St", 7, "3"},
+    {"Houston St", "Canal St", 5, "3"},
+
+    // Additional interchange scenarios (realistic transfers):
+    // "42nd St" is served by Lines 1 and 2.
+    // "34th St" is served by Lines 1 and 3.
+    // Also, let's assume "Grand Central" and "Union Sq" are close enough to be an interchange.
+    {"Grand Central", "Union Sq", 4, "Interchange"},
+}};
+constexpr auto kSampleNetwork = compileNetwork(kSampleStations, kSampleLines, kSampleSegments);
+static_assert(staticRoute(kSampleNetwork, 0, 6, 2).cost == 22, "Times Sq -> Wall St");
+// Station coordinates of the sample network, in kSampleStations order.
+constexpr std::array<ShapePoint, 10> kSampleStationCoords = {{
+    {40755983, -73986229}, {40754222, -73984569}, {40749567, -73987950}, {40750373, -73991057},
+    {40751776, -73976848}, {40737826, -73996786}, {40707557, -74011862}, {40735736, -73990568},
+    {40728251, -74005367}, {40722854, -74006277}}};
+
+// Builds an extended sample subway graph with real NYC subway station names.
+void buildSampleGraph(Graph &graph);
+
+// Fare rules for the sample graph: flat fare with a two-hour free transfer window,
+// and Line "3" running as a premium express with a surcharge.
+FareModel buildSampleFares(const Graph &graph);
+
+// Headway bands for the sample graph: a night service, morning and evening peaks,
+// with Line "3" (the express) running less often.
+FrequencyModel buildSampleFrequencies(const Graph &graph);
+
+// Straight-line segment shapes for the sample graph, from kSampleStationCoords.
+ShapeStore buildSampleShapes(const Graph &graph);
+
+// Generates a city-scale grid network for benchmarks: 'rows' x 'cols' stations,
+// one line per row and per column, so every station is an interchange.
+// Segment costs are drawn from [1, 9].
+void generateCityNetwork(Graph &graph, int rows, int cols, unsigned seed);
+
+} // namespace subway
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "subway/graph.h"
+
+namespace subway {
+
+// Shortest-path tree from a single source over a view, following the same
+// transfer rules as Graph::dijkstra.
+struct SearchTree {
+    int source = -1;
+    std::vector<int> dist;          // numeric_limits<int>::max() when unreachable
+    std::vector<int> parentEdge;    // position in view.edges of the tree edge, -1 if none
+    std::vector<int> parentStation; // tail of the tree edge, -1 if none
+    std::vector<int> arrivalLine;   // line used to reach the station, -1 if none
+    std::vector<int> settleOrder;   // reachable stations in the order the search settled them
+};
+
+// Returns the station an edge of the view leaves from.
+int edgeSource(const GraphView &view, int e);
+
+// Grows the full shortest-path tree of 'source' into 'tree', reusing its storage.
+// When 'edgeCosts' is given it replaces ViewEdge::cost (indexed like view.edges);
+// a negative entry closes the edge.
+void buildSearchTree(const GraphView &view, int source, int transferCost, SearchTree &tree,
+                     const std::vector<int> *edgeCosts = nullptr);
+
+// Repairs a tree grown by buildSearchTree after the cost of one edge changed.
+// 'costs' holds the current edge costs (indexed like view.edges, negative =
+// deleted) and must already contain the new cost of 'changed'. The result equals
+// a fresh buildSearchTree with those costs, also with transfer costs, where a
+// station's label depends on the line it was reached by and not only on its
+// distance: stations the search settles before the tail of the changed edge keep
+// their labels (the settle order is recorded in the tree), and the search resumes
+// from there. A change that cannot alter any relaxation returns at once. Returns the number of stations whose label changed.
+int repairSearchTree(const GraphView &view, int transferCost, const std::vector<int> &costs, int changed,
+                     SearchTree &tree);
+
+} // namespace subway
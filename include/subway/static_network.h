@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <string_view>
+
+#include "subway/cost.h"
+
+namespace subway {
+
+// A bidirectional segment of a compile-time network description.
+struct StaticSegmentSpec {
+    std::string_view from;
+    std::string_view to;
+    int cost;
+    std::string_view line;
+};
+
+// A fixed network compiled into CSR arrays. N stations, L lines, M directed edges;
+// edges of station s are [offsets[s], offsets[s + 1]).
+template <size_t N, size_t L, size_t M>
+struct StaticNetwork {
+    std::array<std::string_view, N> stationNames{};
+    std::array<std::string_view, L> lineNames{};
+    std::array<int, N + 1> offsets{};
+    std::array<int, M> destination{};
+    std::array<int, M> cost{};
+    std::array<int, M> line{};
+};
+
+// Index of 'name' in 'names'. An unknown name is not a constant expression, so a
+// typo in a constexpr network description fails the build.
+template <size_t K>
+constexpr int staticIndexOf(const std::array<std::string_view, K> &names, std::string_view name) {
+    for (size_t i = 0; i < K; i++)
+        if (names[i] == name) return (int)i;
+    throw "unknown name in static network";
+}
+
+// Builds the CSR arrays of a fixed network at compile time.
+template <size_t N, size_t L, size_t S>
+constexpr StaticNetwork<N, L, 2 * S> compileNetwork(const std::array<std::string_view, N> &stations,
+                                                    const std::array<std::string_view, L> &lines,
+                                                    const std::array<StaticSegmentSpec, S> &segments) {
+    StaticNetwork<N, L, 2 * S> net{};
+    net.stationNames = stations;
+    net.lineNames = lines;
+    for (const auto &seg : segments) {
+        net.offsets[staticIndexOf(stations, seg.from) + 1]++;
+        net.offsets[staticIndexOf(stations, seg.to) + 1]++;
+    }
+    for (size_t s = 0; s < N; s++) net.offsets[s + 1] += net.offsets[s];
+    std::array<int, N> cursor{};
+    for (size_t s = 0; s < N; s++) cursor[s] = net.offsets[s];
+    // Edges keep segment order per station, as Graph::addBidirectionalEdge does.
+    for (const auto &seg : segments) {
+        int a = staticIndexOf(stations, seg.from), b = staticIndexOf(stations, seg.to);
+        int line = staticIndexOf(lines, seg.line);
+        int e = cursor[a]++;
+        net.destination[e] = b;
+        net.cost[e] = seg.cost;
+        net.line[e] = line;
+        e = cursor[b]++;
+        net.destination[e] = a;
+        net.cost[e] = seg.cost;
+        net.line[e] = line;
+    }
+    return net;
+}
+
+// Result of staticRoute: stations[0..stops] with the line used to reach each (-1 at the start).
+template <size_t N>
+struct StaticRoute {
+    int cost = -1; // -1 when unreachable
+    int stops = 0;
+    std::array<int, N> stations{};
+    std::array<int, N> lines{};
+};
+
+// Same search as Graph::dijkstra, specialized for a fixed network: all state lives in
+// fixed-size arrays and the next station is found by a linear scan, which beats a
+// heap for small N. Usable in constant expressions.
+template <size_t N, size_t L, size_t M>
+constexpr StaticRoute<N> staticRoute(const StaticNetwork<N, L, M> &net, int source, int destination,
+                                     int transferCost) {
+    const int INF = std::numeric_limits<int>::max();
+    std::array<int, N> dist{}, parent{}, arrival{};
+    std::array<bool, N> done{};
+    for (size_t s = 0; s < N; s++) {
+        dist[s] = INF;
+        parent[s] = -1;
+        arrival[s] = -1;
+    }
+    dist[source] = 0;
+    for (size_t round = 0; round < N; round++) {
+        int u = -1;
+        for (size_t s = 0; s < N; s++)
+            if (!done[s] && dist[s] != INF && (u == -1 || dist[s] < dist[u])) u = (int)s;
+        if (u == -1 || u == destination) break;
+        done[u] = true;
+        for (int e = net.offsets[u]; e < net.offsets[u + 1]; e++) {
+            int extra = (arrival[u] != -1 && arrival[u] != net.line[e]) ? transferCost : 0;
+            int newCost = CostTraits<int>::add(dist[u], net.cost[e] + extra);
+            int v = net.destination[e];
+            if (newCost < dist[v]) {
+                dist[v] = newCost;
+                parent[v] = u;
+                arrival[v] = net.line[e];
+            }
+        }
+    }
+
+    StaticRoute<N> route;
+    if (dist[destination] == INF) return route;
+    route.cost = dist[destination];
+    for (int cur = destination; cur != source; cur = parent[cur]) route.stops++;
+    int i = route.stops;
+    for (int cur = destination; i >= 0; cur = parent[cur], i--) {
+        route.stations[i] = cur;
+        route.lines[i] = arrival[cur];
+    }
+    return route;
+}
+
+} // namespace subway
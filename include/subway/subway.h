@@ -0,0 +1,34 @@
+#pragma once
+
+// Public entry point of the subway_core library. Including this header gives
+// access to the whole routing API; the individual headers can be used instead.
+
+#define SUBWAY_VERSION_MAJOR 1
+#define SUBWAY_VERSION_MINOR 0
+
+#include "subway/arc_flags.h"
+#include "subway/assignment.h"
+#include "subway/async_io.h"
+#include "subway/centrality.h"
+#include "subway/closures.h"
+#include "subway/colors.h"
+#include "subway/cost.h"
+#include "subway/demand.h"
+#include "subway/graph.h"
+#include "subway/graph_file.h"
+#include "subway/interleave.h"
+#include "subway/kernel.h"
+#include "subway/mpmc_queue.h"
+#include "subway/path.h"
+#include "subway/perf_counters.h"
+#include "subway/perfect_hash.h"
+#include "subway/query_parser.h"
+#include "subway/replay.h"
+#include "subway/results.h"
+#include "subway/sample.h"
+#include "subway/search_tree.h"
+#include "subway/static_network.h"
+#include "subway/timetable.h"
+#include "subway/transfer_patterns.h"
+#include "subway/transit_nodes.h"
+#include "subway/trip_based.h"
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "subway/graph.h"
+
+namespace subway {
+
+// Walking link between two stations, taken without waiting.
+struct Footpath {
+    int to;
+    int time;
+};
+
+// Timetable of trips over the stations of a view. A route is one direction of a
+// line as a stop sequence; its trips never overtake, so trips of a route sorted by
+// departure at the first stop are sorted at every stop. An event is one stop of one
+// trip. Times are in cost units (minutes) after midnight.
+struct Timetable {
+    int transferTime = 0; // to change vehicles within a station
+    std::vector<int> routeLine;
+    std::vector<int> routeStopOffsets;
+    std::vector<int> routeStops; // station IDs
+    std::vector<int> routeTripOffsets;
+    std::vector<int> tripRoute;
+    std::vector<int> tripEventOffsets;
+    std::vector<int> arrival;   // by event
+    std::vector<int> departure; // by event
+    std::vector<int> stationStopOffsets;
+    std::vector<std::pair<int, int>> stationStops; // by station, {route, stop index}
+    std::vector<int> footpathOffsets;
+    std::vector<Footpath> footpaths; // by station
+
+    int routeCount() const { return (int)routeLine.size(); }
+    int tripCount() const { return (int)tripRoute.size(); }
+    int stopCount(int route) const { return routeStopOffsets[route + 1] - routeStopOffsets[route]; }
+    int event(int trip, int stop) const { return tripEventOffsets[trip] + stop; }
+
+    // First trip of 'route' leaving stop 'stop' at or after 'time', or -1.
+    int earliestTrip(int route, int stop, int time) const;
+
+    size_t memoryBytes() const;
+};
+
+// Synthesizes a periodic timetable from the lines of 'view': each line is split into
+// unbranched runs, each run served in both directions (where the view has the edges)
+// every 'headway' minutes from 'serviceStart' until 'serviceEnd', with the edge cost
+// as running time. Line starts are staggered so connections differ between stations.
+// "Interchange" edges become footpaths.
+Timetable buildTimetable(const Graph &graph, const GraphView &view, int headway, int serviceStart, int serviceEnd,
+                         int transferTime);
+
+// Earliest arrival at 'target' leaving 'source' at 'departure' or later, with at most
+// 'maxTrips' trips, by RAPTOR; -1 when unreachable. A footpath may be walked at the
+// start, the end, or between two trips.
+int raptorArrival(const Timetable &timetable, int source, int target, int departure, int maxTrips = 16);
+
+} // namespace subway
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "subway/timetable.h"
+
+namespace subway {
+
+// One station of a transfer pattern, reached from its parent by a single trip or
+// by walking one footpath. Node 0 of every origin is the origin itself.
+struct PatternNode {
+    int station;
+    int parent; // within the origin, -1 for the root
+    bool walk;
+};
+
+// Transfer Patterns (Bast et al. 2010): for every origin, the prefix tree of the
+// station sequences of all optimal journeys (by arrival and number of trips) to
+// every target over the preprocessing window. A query evaluates only the patterns
+// of its origin and target, one direct-connection lookup per leg.
+struct TransferPatterns {
+    Timetable timetable;
+    int maxTrips = 0;
+    std::vector<int> nodeOffsets; // by origin
+    std::vector<PatternNode> nodes;
+    std::vector<int> targetOffsets; // by origin * stations + target
+    std::vector<int> targetNodes;   // pattern ends, within the origin
+
+    int stationCount() const { return (int)nodeOffsets.size() - 1; }
+    size_t memoryBytes() const;
+};
+
+// Computes the patterns of journeys leaving between 'from' and 'to' with at most
+// 'maxTrips' trips, by a range RAPTOR from each origin over all its departures.
+// Origins are processed in parallel on 'threads' threads. With a 'progressPath',
+// each finished origin is appended to that file and origins already in it are
+// loaded instead of recomputed, so an interrupted build resumes where it stopped.
+// At most 'originBudget' origins are computed in one call (-1 = all); when the
+// budget runs out first, returns false with the progress saved. 'resumed' receives
+// the number of origins loaded from the file.
+bool buildTransferPatterns(Timetable timetable, int from, int to, int maxTrips, int threads,
+                           const std::string &progressPath, int originBudget, TransferPatterns &patterns,
+                           std::string &error, int *resumed = nullptr);
+
+// Earliest arrival at 'to' by a single trip boarded at 'from' at or after 'time';
+// -1 when no route serves 'from' before 'to' or no trip is left.
+int directConnection(const Timetable &timetable, int from, int to, int time);
+
+// Optimal journey with a given number of trips.
+struct PatternJourney {
+    int arrival;
+    int trips;
+};
+
+// Journeys from 'source' to 'target' leaving at 'departure' or later that are
+// Pareto-optimal in (arrival, trips), fewest trips first; empty when unreachable.
+std::vector<PatternJourney> transferPatternQuery(const TransferPatterns &patterns, int source, int target,
+                                                 int departure);
+
+} // namespace subway
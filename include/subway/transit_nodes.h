@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "subway/centrality.h"
+#include "subway/graph.h"
+
+namespace subway {
+
+// Distance from a station to (or from) one node of the hub table.
+struct AccessEntry {
+    int hub;  // index into the table
+    int cost;
+};
+
+// Transit node routing over the line-aware graph, where costs are the line-level
+// optimum (each transfer charged exactly once), which can be below what the
+// station-level Graph::dijkstra finds. A few hub stations carry most long trips:
+// every node of a hub is a table entry, and each station keeps the hub nodes that
+// start (access) and end (egress) its trips, together with the stations it reaches
+// before every remaining path has passed a hub. Trips to those stations are searched
+// locally; all others are answered from the table.
+struct TransitNodes {
+    LineGraph lineGraph;
+    std::vector<int> hubs;      // station IDs
+    std::vector<int> hubNodes;  // line-graph node of each table entry
+    std::vector<int> table;     // hubNodes.size() squared, row = from
+    std::vector<int> accessOffsets;
+    std::vector<AccessEntry> access; // by station, hub nodes reached first from it
+    std::vector<int> egressOffsets;
+    std::vector<AccessEntry> egress; // by station, last hub nodes on trips into it
+    std::vector<int> localOffsets;
+    std::vector<int> local; // by station, sorted stations searched locally
+
+    size_t memoryBytes() const;
+};
+
+// Picks the 'hubCount' stations of highest betweenness (estimated from 'samples'
+// sources) as hubs and builds the tables. Searches run on 'threads' threads.
+TransitNodes buildTransitNodes(const GraphView &view, int transferCost, int hubCount, int samples, int threads);
+
+// Line-level optimal cost between two stations, -1 when unreachable. 'local' is set
+// to whether the locality filter sent the query to a local search.
+int transitNodeCost(const TransitNodes &tnr, int source, int destination, bool *local = nullptr);
+
+// Plain Dijkstra over a line graph from 'source' until 'destination' is settled;
+// the reference for transitNodeCost.
+int lineGraphCost(const LineGraph &lg, int source, int destination);
+
+} // namespace subway
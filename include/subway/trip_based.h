@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "subway/timetable.h"
+
+namespace subway {
+
+// Transfer from an event to the stop 'stop' of trip 'trip'.
+struct TripTransfer {
+    int trip;
+    int stop;
+};
+
+// Trip-Based routing (Witt 2015) over a timetable: for every event, the transfers
+// to the earliest trip of each route reachable from it, reduced to those that can
+// still improve an arrival somewhere.
+struct TripBased {
+    Timetable timetable;
+    std::vector<int> transferOffsets; // by event
+    std::vector<TripTransfer> transfers;
+
+    size_t memoryBytes() const;
+};
+
+// Computes the transfer set. Transfers leave in the station (after the transfer time)
+// or along one footpath; U-turns and transfers no better than staying seated are
+// dropped, then each trip keeps only transfers that improve some arrival or boarding
+// time when its stops are scanned from the last. Trips are processed in parallel on
+// 'threads' threads.
+TripBased buildTripBased(Timetable timetable, int threads);
+
+// One Pareto-optimal journey of a profile query.
+struct ProfileEntry {
+    int departure;
+    int arrival;
+    int transfers;
+};
+
+// Query state for one thread, reused across queries.
+class TripBasedQuery {
+public:
+    static const int kMaxTrips = 16;
+
+    explicit TripBasedQuery(const TripBased &tripBased);
+
+    // Earliest arrival at 'target' leaving 'source' at 'departure' or later, with the
+    // same walking rules as raptorArrival; -1 when unreachable. 'transfers' receives
+    // the fewest transfers of an earliest journey.
+    int earliestArrival(int source, int target, int departure, int *transfers = nullptr);
+
+    // Journeys leaving 'source' between 'from' and 'to' that are Pareto-optimal in
+    // (later departure, earlier arrival, fewer transfers), latest departure first.
+    // Departures are scanned latest first, keeping the reached-stop labels and
+    // arrival bounds of later departures, so each trip segment is scanned once per
+    // transfer count over the whole range.
+    std::vector<ProfileEntry> profile(int source, int target, int from, int to);
+
+private:
+    struct Segment {
+        int trip;
+        int from; // stops (from, to] are newly reached
+        int to;
+    };
+    struct TargetStop {
+        int stop;  // stop index on the route
+        int delay; // footpath time into the target, 0 at the target itself
+    };
+
+    void reset();
+    // Stops where the target is reached, directly or by one footpath.
+    void setTarget(int target);
+    void enqueue(int trip, int stop, int level);
+    // Runs one departure against the current bounds, appending improvements to 'found'.
+    void scan(int source, int target, int departure, std::vector<ProfileEntry> *found);
+
+    const TripBased &tb;
+    int levels = 1;                   // reached-stop labels in use per trip
+    std::vector<int> reachedStop;     // trips x kMaxTrips, first stop boarded
+    std::vector<int> touchedTrips;
+    std::vector<int> bestArrival;     // by number of trips, 0 = walking only
+    std::vector<std::vector<Segment>> queue;
+    std::vector<std::vector<TargetStop>> targetStops; // by route
+    std::vector<int> targetRoutes;
+};
+
+} // namespace subway
@@ -0,0 +1,257 @@
+#include "subway/arc_flags.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include "subway/cost.h"
+#include "subway/search_tree.h"
+
+namespace subway {
+
+std::vector<int> partitionStations(const GraphView &view, int regions) {
+    const int n = (int)view.offsets.size() - 1;
+    std::vector<int> region(n, -1);
+    if (n == 0) return region;
+    regions = std::max(1, std::min(regions, n));
+
+    // Hop distances from the seeds picked so far; the next seed is the farthest station.
+    std::vector<int> hops(n, std::numeric_limits<int>::max());
+    std::vector<int> seeds;
+    std::vector<int> frontier;
+    int next = 0;
+    while ((int)seeds.size() < regions) {
+        seeds.push_back(next);
+        hops[next] = 0;
+        frontier.assign(1, next);
+        for (size_t i = 0; i < frontier.size(); i++) {
+            int s = frontier[i];
+            for (int e = view.offsets[s]; e < view.offsets[s + 1]; e++) {
+                int d = view.edges[e].destination;
+                if (hops[s] + 1 < hops[d]) {
+                    hops[d] = hops[s] + 1;
+                    frontier.push_back(d);
+                }
+            }
+        }
+        next = (int)(std::max_element(hops.begin(), hops.end()) - hops.begin());
+        if (hops[next] == 0) break;
+    }
+
+    // Grow all regions at once, one ring per round, so each station joins the nearest seed.
+    frontier.clear();
+    for (size_t r = 0; r < seeds.size(); r++) {
+        region[seeds[r]] = (int)r;
+        frontier.push_back(seeds[r]);
+    }
+    for (size_t i = 0; i < frontier.size(); i++) {
+        int s = frontier[i];
+        for (int e = view.offsets[s]; e < view.offsets[s + 1]; e++) {
+            int d = view.edges[e].destination;
+            if (region[d] == -1) {
+                region[d] = region[s];
+                frontier.push_back(d);
+            }
+        }
+    }
+    // Stations no seed reaches are spread over the regions round robin.
+    for (int s = 0, r = 0; s < n; s++) {
+        if (region[s] == -1) region[s] = r++ % (int)seeds.size();
+    }
+    return region;
+}
+
+// Labels of a search restricted to edges carrying 'bit'.
+struct FlaggedSearch {
+    std::vector<int> dist;
+    std::vector<int> parentEdge;
+    std::vector<int> arrivalLine;
+};
+
+// Runs the restricted search from 'source' until 'settled' returns true for a
+// settled station, or the queue runs dry.
+template <class Settled>
+static void flaggedSearch(const GraphView &view, const std::vector<uint64_t> &flags, uint64_t bit, int source,
+                          int transferCost, FlaggedSearch &search, Settled settled) {
+    const int n = (int)view.offsets.size() - 1;
+    search.dist.assign(n, std::numeric_limits<int>::max());
+    search.parentEdge.assign(n, -1);
+    search.arrivalLine.assign(n, -1);
+    search.dist[source] = 0;
+
+    typedef std::pair<int, int> QueueEntry; // {cost, station}
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+    pq.push({0, source});
+    while (!pq.empty()) {
+        auto [cost, station] = pq.top();
+        pq.pop();
+        if (cost > search.dist[station])
+            continue;
+        if (settled(station))
+            break;
+        for (int e = view.offsets[station]; e < view.offsets[station + 1]; e++) {
+            if (!(flags[e] & bit))
+                continue;
+            const ViewEdge &edge = view.edges[e];
+            int extra = 0;
+            if (search.arrivalLine[station] != -1 && search.arrivalLine[station] != edge.lineId)
+                extra = transferCost;
+            int newCost = CostTraits<int>::add(cost, edge.cost + extra);
+            if (newCost < search.dist[edge.destination]) {
+                search.dist[edge.destination] = newCost;
+                search.parentEdge[edge.destination] = e;
+                search.arrivalLine[edge.destination] = edge.lineId;
+                pq.push({newCost, edge.destination});
+            }
+        }
+    }
+}
+
+ArcFlags buildArcFlags(const GraphView &view, int transferCost, int regions, int threads) {
+    const int n = (int)view.offsets.size() - 1;
+    const size_t m = view.edges.size();
+    ArcFlags arcFlags;
+    arcFlags.region = partitionStations(view, std::max(1, std::min(regions, 64)));
+    for (int r : arcFlags.region) arcFlags.regionCount = std::max(arcFlags.regionCount, r + 1);
+    std::vector<std::vector<int>> members(arcFlags.regionCount);
+    for (int s = 0; s < n; s++) members[arcFlags.region[s]].push_back(s);
+    arcFlags.flags.assign(m, 0);
+
+    // Runs 'perSource' for every station on 'threads' threads, each with its own tree
+    // and list of {edge, flags} additions, then applies the additions and returns the
+    // regions that gained flags.
+    threads = std::max(1, threads);
+    typedef std::vector<std::pair<int, uint64_t>> Additions;
+    auto forEachSource = [&](const std::function<void(const SearchTree &, Additions &)> &perSource) {
+        std::vector<Additions> added(threads);
+        std::atomic<int> next(0);
+        auto worker = [&](int t) {
+            SearchTree tree;
+            for (int source = next++; source < n; source = next++) {
+                buildSearchTree(view, source, transferCost, tree);
+                perSource(tree, added[t]);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+        worker(0);
+        for (auto &t : pool) t.join();
+        uint64_t changed = 0;
+        for (const Additions &list : added) {
+            for (const auto &[e, bits] : list) {
+                changed |= bits & ~arcFlags.flags[e];
+                arcFlags.flags[e] |= bits;
+            }
+        }
+        return changed;
+    };
+    // Adds the tree path of 'station' to the edges flagged with 'bit'.
+    auto addTreePath = [](const SearchTree &tree, int station, uint64_t bit, Additions &out) {
+        for (int cur = station; tree.parentEdge[cur] != -1; cur = tree.parentStation[cur])
+            out.push_back({tree.parentEdge[cur], bit});
+    };
+
+    // Every edge on the tree path from any station into region r gets bit r.
+    forEachSource([&](const SearchTree &tree, Additions &out) {
+        std::vector<uint64_t> mark(m, 0);
+        for (int target = 0; target < n; target++) {
+            const uint64_t bit = uint64_t(1) << arcFlags.region[target];
+            // Once an edge carries the bit, so do all edges above it.
+            for (int cur = target; tree.parentEdge[cur] != -1; cur = tree.parentStation[cur]) {
+                uint64_t &flags = mark[tree.parentEdge[cur]];
+                if (flags & bit) break;
+                flags |= bit;
+            }
+        }
+        for (size_t e = 0; e < m; e++)
+            if (mark[e]) out.push_back({(int)e, mark[e]});
+    });
+
+    // That is not enough on its own: the search keeps one label per station, and a
+    // station whose tree path was pruned may get another label and relax a different
+    // edge into a target's path. Repeat the restricted search from every source, and
+    // for each target reached differently follow the culprits back until a station
+    // whose tree path is missing flags; add that path. Flags only grow, and only
+    // regions that gained flags need another pass; a pass that adds nothing proves
+    // every query matches the unrestricted search. A region whose mismatches add no
+    // flags would never be fixed, so it falls back to flagging every edge.
+    for (uint64_t pending = ~uint64_t(0); pending != 0;) {
+        std::atomic<uint64_t> mismatched(0);
+        pending = forEachSource([&](const SearchTree &tree, Additions &out) {
+            FlaggedSearch search;
+            std::vector<int> path, work;
+            std::vector<char> seen(n, 0);
+            for (int r = 0; r < arcFlags.regionCount; r++) {
+                const uint64_t bit = uint64_t(1) << r;
+                if (!(pending & bit)) continue;
+                // Labels are final once settled, so stop when the whole region is.
+                int remaining = (int)members[r].size();
+                flaggedSearch(view, arcFlags.flags, bit, tree.source, transferCost, search,
+                              [&](int station) { return arcFlags.region[station] == r && --remaining == 0; });
+                auto matches = [&](int s) {
+                    return search.dist[s] == tree.dist[s] && search.parentEdge[s] == tree.parentEdge[s];
+                };
+                std::fill(seen.begin(), seen.end(), 0);
+                for (int target : members[r]) {
+                    // The whole path is returned, so every station on it must match.
+                    work.assign(1, target);
+                    while (!work.empty()) {
+                        int station = work.back();
+                        work.pop_back();
+                        if (seen[station]) continue;
+                        seen[station] = 1;
+                        path.clear();
+                        for (int cur = station; cur != -1; cur = tree.parentStation[cur]) path.push_back(cur);
+                        // First station on the tree path (from the source) labelled differently.
+                        int first = -1;
+                        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                            if (!matches(*it)) {
+                                first = *it;
+                                break;
+                            }
+                        }
+                        if (first == -1) continue;
+                        mismatched |= bit;
+                        if (!(arcFlags.flags[tree.parentEdge[first]] & bit)) {
+                            addTreePath(tree, station, bit, out);
+                            continue;
+                        }
+                        // Its tree edge was offered correctly, so the edge that won came
+                        // from a station with a different label. A station reached another
+                        // way can also be what made its own path cheaper, so follow both.
+                        if (search.parentEdge[first] != -1 && search.parentEdge[first] != tree.parentEdge[first])
+                            work.push_back(edgeSource(view, search.parentEdge[first]));
+                        if (station != first && search.parentEdge[station] != -1 && !matches(station))
+                            work.push_back(edgeSource(view, search.parentEdge[station]));
+                    }
+                }
+            }
+        });
+        if (uint64_t stalled = mismatched & ~pending) {
+            for (uint64_t &flags : arcFlags.flags) flags |= stalled;
+        }
+    }
+    return arcFlags;
+}
+
+PackedPath findPathArcFlags(const GraphView &view, const ArcFlags &arcFlags, int source, int destination,
+                            int transferCost) {
+    FlaggedSearch search;
+    flaggedSearch(view, arcFlags.flags, uint64_t(1) << arcFlags.region[destination], source, transferCost,
+                  search, [destination](int station) { return station == destination; });
+    PackedPath path;
+    path.source = source;
+    if (search.dist[destination] == std::numeric_limits<int>::max()) return path;
+    path.cost = search.dist[destination];
+    for (int cur = destination; cur != source; cur = edgeSource(view, search.parentEdge[cur])) {
+        path.edges.push_back(search.parentEdge[cur]);
+    }
+    std::reverse(path.edges.begin(), path.edges.end());
+    return path;
+}
+
+} // namespace subway
@@ -0,0 +1,112 @@
+#include "subway/assignment.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "subway/search_tree.h"
+
+namespace subway {
+
+// Routes all demand on the current costs and returns the resulting edge flows
+// (all-or-nothing). One shortest-path tree is grown per origin; origins are
+// spread over 'threads' workers which add trips into shared atomic counters.
+static std::vector<double> allOrNothing(const GraphView &view, const std::vector<OdDemand> &demand,
+                                        const std::vector<size_t> &originStarts, int transferCost,
+                                        const std::vector<int> &edgeCosts, int threads) {
+    std::vector<std::atomic<double>> flow(view.edges.size());
+    for (auto &f : flow) f.store(0, std::memory_order_relaxed);
+    std::atomic<size_t> nextGroup(0);
+    size_t groups = originStarts.size() - 1;
+
+    auto worker = [&]() {
+        SearchTree tree;
+        for (size_t g = nextGroup++; g < groups; g = nextGroup++) {
+            buildSearchTree(view, demand[originStarts[g]].origin, transferCost, tree, &edgeCosts);
+            for (size_t i = originStarts[g]; i < originStarts[g + 1]; i++) {
+                const OdDemand &od = demand[i];
+                if (tree.dist[od.destination] == std::numeric_limits<int>::max()) continue;
+                for (int cur = od.destination; cur != od.origin; cur = tree.parentStation[cur]) {
+                    atomicAdd(flow[tree.parentEdge[cur]], od.trips);
+                }
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+
+    std::vector<double> result(flow.size());
+    for (size_t e = 0; e < flow.size(); e++) result[e] = flow[e].load(std::memory_order_relaxed);
+    return result;
+}
+
+AssignmentResult assignTraffic(const GraphView &view, std::vector<OdDemand> demand, int transferCost,
+                               const std::vector<double> &capacity, AssignmentMethod method,
+                               int maxIterations, double targetGap, int threads) {
+    const double scale = 100.0;
+    const size_t m = view.edges.size();
+
+    // Group demand by origin so each tree is shared by all of its destinations.
+    std::sort(demand.begin(), demand.end(),
+              [](const OdDemand &a, const OdDemand &b) { return a.origin < b.origin; });
+    std::vector<size_t> originStarts;
+    for (size_t i = 0; i < demand.size(); i++) {
+        if (i == 0 || demand[i].origin != demand[i - 1].origin) originStarts.push_back(i);
+    }
+    originStarts.push_back(demand.size());
+
+    AssignmentResult result;
+    result.cost.resize(m);
+    std::vector<int> edgeCosts(m);
+    auto updateCosts = [&](const std::vector<double> &flow) {
+        for (size_t e = 0; e < m; e++) {
+            result.cost[e] = congestedCost(view.edges[e].cost, flow[e], capacity[e]);
+            edgeCosts[e] = (int)std::llround(result.cost[e] * scale);
+        }
+    };
+
+    std::vector<double> zero(m, 0.0);
+    updateCosts(zero);
+    result.flow = allOrNothing(view, demand, originStarts, (int)(transferCost * scale), edgeCosts, threads);
+    result.iterations = 1;
+    updateCosts(result.flow);
+
+    while (result.iterations < maxIterations) {
+        std::vector<double> target = allOrNothing(view, demand, originStarts, (int)(transferCost * scale),
+                                                  edgeCosts, threads);
+        double currentTotal = 0, targetTotal = 0;
+        for (size_t e = 0; e < m; e++) {
+            currentTotal += result.cost[e] * result.flow[e];
+            targetTotal += result.cost[e] * target[e];
+        }
+        result.relativeGap = currentTotal > 0 ? (currentTotal - targetTotal) / currentTotal : 0;
+        if (result.relativeGap <= targetGap) break;
+
+        double step = 1.0 / (result.iterations + 1);
+        if (method == ASSIGN_FRANK_WOLFE) {
+            // Bisection on the derivative of the Beckmann objective along the direction.
+            double lo = 0, hi = 1;
+            for (int i = 0; i < 30; i++) {
+                double mid = (lo + hi) / 2, slope = 0;
+                for (size_t e = 0; e < m; e++) {
+                    double d = target[e] - result.flow[e];
+                    slope += congestedCost(view.edges[e].cost, result.flow[e] + mid * d, capacity[e]) * d;
+                }
+                if (slope > 0) hi = mid;
+                else lo = mid;
+            }
+            step = (lo + hi) / 2;
+        }
+        for (size_t e = 0; e < m; e++) {
+            result.flow[e] += step * (target[e] - result.flow[e]);
+        }
+        updateCosts(result.flow);
+        result.iterations++;
+    }
+    return result;
+}
+
+} // namespace subway
@@ -0,0 +1,347 @@
+#include "subway/async_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define SUBWAY_HAVE_IO_URING 1
+#endif
+
+namespace subway {
+
+#ifdef SUBWAY_HAVE_IO_URING
+
+// Minimal io_uring binding over the raw system calls (no liburing): one
+// submission ring, one completion ring, and an iovec per request slot.
+struct AsyncFile::Uring {
+    static constexpr unsigned entries = 8;
+
+    int fd = -1;
+    void *sqRing = nullptr, *cqRing = nullptr;
+    size_t sqRingBytes = 0, cqRingBytes = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesBytes = 0;
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    iovec iov[entries];
+    unsigned freeSlots = (1u << entries) - 1;
+
+    bool setup() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0) return false;
+        sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+        sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) return sqRing = nullptr, false;
+        cqRing = single ? sqRing
+                        : mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) return cqRing = nullptr, false;
+        sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqeMap = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) return false;
+        sqes = (io_uring_sqe *)sqeMap;
+        char *sq = (char *)sqRing, *cq = (char *)cqRing;
+        sqTail = (unsigned *)(sq + params.sq_off.tail);
+        sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+        sqArray = (unsigned *)(sq + params.sq_off.array);
+        cqHead = (unsigned *)(cq + params.cq_off.head);
+        cqTail = (unsigned *)(cq + params.cq_off.tail);
+        cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~Uring() {
+        if (sqes) munmap(sqes, sqesBytes);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingBytes);
+        if (sqRing) munmap(sqRing, sqRingBytes);
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool submit(int file, bool write, void *buffer, size_t size, uint64_t offset, int tag) {
+        if (!freeSlots) return false;
+        unsigned slot = (unsigned)__builtin_ctz(freeSlots);
+        freeSlots &= ~(1u << slot);
+        iov[slot] = {buffer, size};
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe.fd = file;
+        sqe.addr = (uint64_t)(uintptr_t)&iov[slot];
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = ((uint64_t)(uint32_t)tag << 32) | slot;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        if (syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0) < 0) {
+            // The kernel did not take the entry; take it back.
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            freeSlots |= 1u << slot;
+            return false;
+        }
+        return true;
+    }
+
+    bool wait(int &tag, long long &result) {
+        for (;;) {
+            unsigned head = *cqHead;
+            if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe &cqe = cqes[head & *cqMask];
+                tag = (int)(uint32_t)(cqe.user_data >> 32);
+                result = cqe.res;
+                freeSlots |= 1u << (unsigned)(cqe.user_data & 0xffffffffu);
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                return false;
+        }
+    }
+};
+
+#else
+
+struct AsyncFile::Uring {
+    bool setup() { return false; }
+    bool submit(int, bool, void *, size_t, uint64_t, int) { return false; }
+    bool wait(int &, long long &) { return false; }
+};
+
+#endif
+
+AsyncFile::AsyncFile() = default;
+
+AsyncFile::~AsyncFile() {
+    close();
+}
+
+bool AsyncFile::open(const std::string &path, bool write, std::string &error) {
+    close();
+    fd = write ? ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)
+               : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::string(write ? "cannot create " : "cannot open ") + path + ": " + std::strerror(errno);
+        return false;
+    }
+    const char *disable = std::getenv("SUBWAY_NO_URING");
+    if (!disable || !*disable || *disable == '0') {
+        ring.reset(new Uring);
+        if (!ring->setup()) ring.reset();
+    }
+    return true;
+}
+
+void AsyncFile::close() {
+    int tag;
+    long long result;
+    while (pending > 0 && wait(tag, result)) {
+    }
+    ring.reset();
+    completed.clear();
+    pending = 0;
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool AsyncFile::submit(bool write, void *buffer, size_t size, uint64_t offset, int tag) {
+    if (fd < 0) return false;
+    if (ring && ring->submit(fd, write, buffer, size, offset, tag)) {
+        pending++;
+        return true;
+    }
+    // Synchronous fallback: transfer everything now, retrying short transfers.
+    size_t done = 0;
+    long long result = 0;
+    while (done < size) {
+        ssize_t n = write ? pwrite(fd, (const char *)buffer + done, size - done, (off_t)(offset + done))
+                          : pread(fd, (char *)buffer + done, size - done, (off_t)(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            result = -errno;
+            break;
+        }
+        if (n == 0) break;
+        done += (size_t)n;
+        result = (long long)done;
+    }
+    completed.push_back({tag, result});
+    pending++;
+    return true;
+}
+
+bool AsyncFile::submitRead(void *buffer, size_t size, uint64_t offset, int tag) {
+    return submit(false, buffer, size, offset, tag);
+}
+
+bool AsyncFile::submitWrite(const void *buffer, size_t size, uint64_t offset, int tag) {
+    return submit(true, const_cast<void *>(buffer), size, offset, tag);
+}
+
+bool AsyncFile::wait(int &tag, long long &result) {
+    if (pending == 0) return false;
+    if (!completed.empty()) {
+        tag = completed.front().tag;
+        result = completed.front().result;
+        completed.pop_front();
+    } else if (!ring || !ring->wait(tag, result)) {
+        return false;
+    }
+    pending--;
+    return true;
+}
+
+ChunkReader::ChunkReader(size_t chunkBytes) {
+    buffers[0].resize(chunkBytes);
+    buffers[1].resize(chunkBytes);
+}
+
+bool ChunkReader::open(const std::string &path, std::string &error) {
+    if (!file.open(path, false, error)) return false;
+    struct stat info;
+    if (fstat(file.descriptor(), &info) != 0) {
+        error = "cannot stat " + path;
+        return false;
+    }
+    fileSize = (uint64_t)info.st_size;
+    readOffset = 0;
+    done = fileSize == 0;
+    if (!done && !file.submitRead(buffers[0].data(), buffers[0].size(), 0, 0)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    return true;
+}
+
+void ChunkReader::close() {
+    file.close();
+}
+
+bool ChunkReader::next(const uint8_t *&data, size_t &size, std::string &error) {
+    error.clear();
+    int tag;
+    long long result;
+    if (done || !file.wait(tag, result)) return false;
+    if (result <= 0) {
+        error = result < 0 ? std::string("read failed: ") + std::strerror((int)-result) : "unexpected end of file";
+        return false;
+    }
+    // Start on the next chunk before handing this one out.
+    readOffset += (uint64_t)result;
+    if (readOffset < fileSize) {
+        if (!file.submitRead(buffers[1 - tag].data(), buffers[1 - tag].size(), readOffset, 1 - tag)) {
+            error = "read failed";
+            return false;
+        }
+    } else {
+        done = true;
+    }
+    data = buffers[tag].data();
+    size = (size_t)result;
+    return true;
+}
+
+ChunkWriter::ChunkWriter(size_t chunkBytes) : chunkBytes(chunkBytes) {
+    buffers[0].reserve(chunkBytes);
+    buffers[1].reserve(chunkBytes);
+}
+
+ChunkWriter::~ChunkWriter() {
+    std::string error;
+    close(error);
+}
+
+bool ChunkWriter::open(const std::string &path, std::string &error) {
+    written = 0;
+    current = 0;
+    expected = 0;
+    buffers[0].clear();
+    buffers[1].clear();
+    if (!file.open(path, true, error)) return false;
+    uring = file.usingUring();
+    return true;
+}
+
+bool ChunkWriter::waitWrite(std::string &error) {
+    size_t done = 0;
+    while (file.inFlight() > 0) {
+        int tag;
+        long long result;
+        if (!file.wait(tag, result)) {
+            error = "write failed";
+            return false;
+        }
+        if (result == -EINTR || result == -EAGAIN) result = 0;
+        else if (result < 0) {
+            error = std::string("write failed: ") + std::strerror((int)-result);
+            return false;
+        } else if (result == 0) {
+            error = "write failed: no progress";
+            return false;
+        }
+        // A partial completion is legal: submit the rest at the new offset, as the
+        // pwrite fallback loops.
+        done += (size_t)result;
+        if (done < expected &&
+            !file.submitWrite(buffers[tag].data() + done, expected - done, inFlightOffset + done, tag)) {
+            error = "write failed";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ChunkWriter::flush(std::string &error) {
+    std::vector<uint8_t> &buffer = buffers[current];
+    if (buffer.empty()) return true;
+    // The other buffer must be on disk before it can be refilled.
+    if (!waitWrite(error)) return false;
+    expected = buffer.size();
+    inFlightOffset = written;
+    if (!file.submitWrite(buffer.data(), buffer.size(), written, current)) {
+        error = "write failed";
+        return false;
+    }
+    written += buffer.size();
+    current = 1 - current;
+    buffers[current].clear();
+    return true;
+}
+
+bool ChunkWriter::write(const void *data, size_t size, std::string &error) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (size > 0) {
+        std::vector<uint8_t> &buffer = buffers[current];
+        size_t take = std::min(size, chunkBytes - buffer.size());
+        buffer.insert(buffer.end(), bytes, bytes + take);
+        bytes += take;
+        size -= take;
+        if (buffer.size() == chunkBytes && !flush(error)) return false;
+    }
+    return true;
+}
+
+bool ChunkWriter::close(std::string &error) {
+    if (!file.isOpen()) return true;
+    bool ok = flush(error) && waitWrite(error);
+    file.close();
+    return ok;
+}
+
+} // namespace subway
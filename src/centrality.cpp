@@ -0,0 +1,155 @@
+#include "subway/centrality.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <thread>
+#include <utility>
+
+#include "subway/search_tree.h"
+
+namespace subway {
+
+LineGraph buildLineGraph(const GraphView &view, int transferCost) {
+    LineGraph lg;
+    const int n = (int)view.offsets.size() - 1;
+    // Lines arriving at each station; node IDs are assigned per station in line order.
+    std::vector<std::vector<int>> arriving(n);
+    for (const ViewEdge &edge : view.edges) arriving[edge.destination].push_back(edge.lineId);
+    std::vector<int> firstNode(n + 1);
+    std::vector<int> nodeLine;
+    for (int s = 0; s < n; s++) {
+        std::sort(arriving[s].begin(), arriving[s].end());
+        arriving[s].erase(std::unique(arriving[s].begin(), arriving[s].end()), arriving[s].end());
+        firstNode[s] = (int)lg.station.size();
+        lg.startNode.push_back(firstNode[s]);
+        lg.station.push_back(s);
+        nodeLine.push_back(-1);
+        for (int line : arriving[s]) {
+            lg.station.push_back(s);
+            nodeLine.push_back(line);
+        }
+    }
+    firstNode[n] = (int)lg.station.size();
+    auto nodeOf = [&](int s, int line) {
+        auto it = std::lower_bound(arriving[s].begin(), arriving[s].end(), line);
+        return firstNode[s] + 1 + (int)(it - arriving[s].begin());
+    };
+    for (size_t v = 0; v < lg.station.size(); v++) {
+        lg.offsets.push_back((int)lg.to.size());
+        int s = lg.station[v];
+        for (int e = view.offsets[s]; e < view.offsets[s + 1]; e++) {
+            const ViewEdge &edge = view.edges[e];
+            int extra = (nodeLine[v] != -1 && nodeLine[v] != edge.lineId) ? transferCost : 0;
+            lg.from.push_back((int)v);
+            lg.to.push_back(nodeOf(edge.destination, edge.lineId));
+            lg.cost.push_back(edge.cost + extra);
+            lg.viewEdge.push_back(e);
+        }
+    }
+    lg.offsets.push_back((int)lg.to.size());
+    return lg;
+}
+
+Centrality betweennessCentrality(const GraphView &view, int transferCost, int samples,
+                                 unsigned seed, int threads) {
+    LineGraph lg = buildLineGraph(view, transferCost);
+    const int n = (int)view.offsets.size() - 1;
+    const int nodes = (int)lg.station.size();
+
+    std::vector<int> sources(n);
+    std::iota(sources.begin(), sources.end(), 0);
+    double scale = 1.0;
+    if (samples > 0 && samples < n) {
+        std::mt19937 rng(seed);
+        std::shuffle(sources.begin(), sources.end(), rng);
+        sources.resize(samples);
+        scale = (double)n / samples;
+    }
+
+    threads = std::max(1, threads);
+    std::vector<Centrality> partial(threads);
+    std::atomic<size_t> next(0);
+    auto worker = [&](int t) {
+        Centrality &out = partial[t];
+        out.station.assign(n, 0);
+        out.edge.assign(view.edges.size(), 0);
+        std::vector<int> dist(nodes), stationDist(n);
+        std::vector<double> sigma(nodes), stationSigma(n), delta(nodes);
+        std::vector<std::vector<int>> predEdges(nodes); // expanded edges on shortest paths into a node
+        std::vector<int> order;
+        for (size_t i = next++; i < sources.size(); i = next++) {
+            std::fill(dist.begin(), dist.end(), std::numeric_limits<int>::max());
+            std::fill(sigma.begin(), sigma.end(), 0.0);
+            std::fill(delta.begin(), delta.end(), 0.0);
+            for (auto &p : predEdges) p.clear();
+            order.clear();
+
+            int src = lg.startNode[sources[i]];
+            dist[src] = 0;
+            sigma[src] = 1;
+            typedef std::pair<int, int> QueueEntry;
+            std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+            pq.push({0, src});
+            while (!pq.empty()) {
+                auto [d, v] = pq.top();
+                pq.pop();
+                if (d > dist[v]) continue;
+                order.push_back(v);
+                for (int x = lg.offsets[v]; x < lg.offsets[v + 1]; x++) {
+                    int w = lg.to[x];
+                    int nd = d + lg.cost[x];
+                    if (nd < dist[w]) {
+                        dist[w] = nd;
+                        sigma[w] = 0;
+                        predEdges[w].clear();
+                        pq.push({nd, w});
+                    }
+                    if (nd == dist[w]) {
+                        sigma[w] += sigma[v];
+                        predEdges[w].push_back(x);
+                    }
+                }
+            }
+
+            // A station is reached optimally at each of its nodes that attains its minimum distance.
+            std::fill(stationDist.begin(), stationDist.end(), std::numeric_limits<int>::max());
+            std::fill(stationSigma.begin(), stationSigma.end(), 0.0);
+            for (int v : order) stationDist[lg.station[v]] = std::min(stationDist[lg.station[v]], dist[v]);
+            for (int v : order)
+                if (dist[v] == stationDist[lg.station[v]]) stationSigma[lg.station[v]] += sigma[v];
+
+            // Dependency accumulation in order of non-increasing distance.
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                int w = *it;
+                int s = lg.station[w];
+                double through = delta[w];
+                if (s != sources[i] && dist[w] == stationDist[s]) through += sigma[w] / stationSigma[s];
+                for (int x : predEdges[w]) {
+                    int from = lg.from[x];
+                    double share = sigma[from] / sigma[w] * through;
+                    delta[from] += share;
+                    out.edge[lg.viewEdge[x]] += share * scale;
+                }
+                if (s != sources[i]) out.station[s] += delta[w] * scale;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto &t : pool) t.join();
+
+    Centrality result = std::move(partial[0]);
+    for (int t = 1; t < threads; t++) {
+        for (int s = 0; s < n; s++) result.station[s] += partial[t].station[s];
+        for (size_t e = 0; e < result.edge.size(); e++) result.edge[e] += partial[t].edge[e];
+    }
+    return result;
+}
+
+} // namespace subway
@@ -0,0 +1,98 @@
+#include "subway/closures.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+#include "subway/search_tree.h"
+
+namespace subway {
+
+std::vector<std::vector<int>> viewSegments(const GraphView &view) {
+    std::vector<std::vector<int>> segments;
+    std::vector<char> taken(view.edges.size(), 0);
+    for (int e = 0; e < (int)view.edges.size(); e++) {
+        if (taken[e]) continue;
+        taken[e] = 1;
+        std::vector<int> segment{e};
+        int from = edgeSource(view, e);
+        const ViewEdge &edge = view.edges[e];
+        for (int r = view.offsets[edge.destination]; r < view.offsets[edge.destination + 1]; r++) {
+            if (!taken[r] && view.edges[r].destination == from && view.edges[r].lineId == edge.lineId) {
+                taken[r] = 1;
+                segment.push_back(r);
+                break;
+            }
+        }
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+std::vector<ClosureImpact> simulateClosures(const GraphView &view, std::vector<OdDemand> demand,
+                                            int transferCost, int threads) {
+    std::sort(demand.begin(), demand.end(),
+              [](const OdDemand &a, const OdDemand &b) { return a.origin < b.origin; });
+    std::vector<size_t> originStarts;
+    for (size_t i = 0; i < demand.size(); i++) {
+        if (i == 0 || demand[i].origin != demand[i - 1].origin) originStarts.push_back(i);
+    }
+    originStarts.push_back(demand.size());
+    const size_t groups = originStarts.size() - 1;
+
+    // Baseline costs per OD pair, and which origins' trees contain each edge. The
+    // whole tree is marked, not just the paths to demanded destinations: with
+    // transfer costs, closing an edge that only changes the line some station is
+    // reached on can make another destination cheaper.
+    std::vector<int> baseCost(demand.size());
+    std::vector<std::vector<int>> treesUsingEdge(view.edges.size());
+    SearchTree tree;
+    for (size_t g = 0; g < groups; g++) {
+        buildSearchTree(view, demand[originStarts[g]].origin, transferCost, tree);
+        for (size_t i = originStarts[g]; i < originStarts[g + 1]; i++) baseCost[i] = tree.dist[demand[i].destination];
+        for (int e : tree.parentEdge) {
+            if (e != -1) treesUsingEdge[e].push_back((int)g);
+        }
+    }
+
+    std::vector<std::vector<int>> segments = viewSegments(view);
+    std::vector<ClosureImpact> impacts(segments.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        SearchTree local;
+        std::vector<int> costs(view.edges.size());
+        for (size_t e = 0; e < costs.size(); e++) costs[e] = view.edges[e].cost;
+        for (size_t c = next++; c < segments.size(); c = next++) {
+            ClosureImpact &impact = impacts[c];
+            impact.edges = segments[c];
+            std::vector<int> affected;
+            for (int e : impact.edges) {
+                affected.insert(affected.end(), treesUsingEdge[e].begin(), treesUsingEdge[e].end());
+                costs[e] = -1;
+            }
+            std::sort(affected.begin(), affected.end());
+            affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+            impact.researchedOrigins = (int)affected.size();
+            for (int g : affected) {
+                buildSearchTree(view, demand[originStarts[g]].origin, transferCost, local, &costs);
+                for (size_t i = originStarts[g]; i < originStarts[g + 1]; i++) {
+                    int before = baseCost[i], after = local.dist[demand[i].destination];
+                    if (before == after) continue;
+                    impact.affectedTrips += demand[i].trips;
+                    if (after == std::numeric_limits<int>::max()) impact.unservedTrips += demand[i].trips;
+                    else if (before != std::numeric_limits<int>::max()) impact.extraCost += demand[i].trips * (after - before);
+                }
+            }
+            for (int e : impact.edges) costs[e] = view.edges[e].cost;
+        }
+    };
+    threads = std::max(1, threads);
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+    return impacts;
+}
+
+} // namespace subway
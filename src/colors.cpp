@@ -0,0 +1,15 @@
+#include "subway/colors.h"
+
+namespace subway {
+
+std::string getColor(const std::string &line) {
+    if (line == "1") return "\033[31m";         // red
+    if (line == "2") return "\033[32m";         // green
+    if (line == "3") return "\033[34m";         // blue
+    if (line == "Interchange") return "\033[35m"; // magenta
+    return "\033[0m";                           // default
+}
+
+const std::string reset = "\033[0m";
+
+} // namespace subway
@@ -0,0 +1,272 @@
+#include "subway/demand.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include "subway/search_tree.h"
+
+namespace subway {
+
+bool loadOdMatrix(const std::string &path, const Graph &graph, std::vector<OdDemand> &demand, std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    const uint32_t n = (uint32_t)graph.stationNames.size();
+    demand.clear();
+
+    char magic[4] = {};
+    in.read(magic, 4);
+    if (in.gcount() == 4 && std::memcmp(magic, "ODM1", 4) == 0) {
+        uint32_t layout = 0, count = 0;
+        in.read((char *)&layout, sizeof(layout));
+        in.read((char *)&count, sizeof(count));
+        if (!in || count != n) {
+            error = "binary matrix does not match the graph's " + std::to_string(n) + " stations";
+            return false;
+        }
+        if (layout == 0) {
+            std::vector<float> row(n);
+            for (uint32_t o = 0; o < n; o++) {
+                if (!in.read((char *)row.data(), n * sizeof(float))) {
+                    error = "truncated dense matrix";
+                    return false;
+                }
+                for (uint32_t d = 0; d < n; d++)
+                    if (row[d] > 0 && o != d) demand.push_back({(int)o, (int)d, row[d]});
+            }
+        } else {
+            uint64_t records = 0;
+            in.read((char *)&records, sizeof(records));
+            struct Record {
+                uint32_t origin, destination;
+                float trips;
+            };
+            std::vector<Record> block(4096);
+            while (records > 0 && in) {
+                size_t take = (size_t)std::min<uint64_t>(records, block.size());
+                if (!in.read((char *)block.data(), take * sizeof(Record))) break;
+                for (size_t i = 0; i < take; i++) {
+                    const Record &r = block[i];
+                    if (r.origin >= n || r.destination >= n) {
+                        error = "station ID out of range";
+                        return false;
+                    }
+                    if (r.trips > 0 && r.origin != r.destination)
+                        demand.push_back({(int)r.origin, (int)r.destination, r.trips});
+                }
+                records -= take;
+            }
+            if (records > 0) {
+                error = "truncated sparse matrix";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // CSV.
+    in.clear();
+    in.seekg(0);
+    auto split = [](const std::string &line) {
+        std::vector<std::string> cells;
+        std::stringstream ss(line);
+        std::string cell;
+        while (std::getline(ss, cell, ',')) {
+            while (!cell.empty() && (cell.back() == '\r' || cell.back() == ' ')) cell.pop_back();
+            while (!cell.empty() && cell.front() == ' ') cell.erase(cell.begin());
+            cells.push_back(cell);
+        }
+        return cells;
+    };
+    auto stationOf = [&](const std::string &cell) {
+        int id = graph.findStation(cell);
+        if (id >= 0) return id;
+        if (!cell.empty() && std::all_of(cell.begin(), cell.end(), ::isdigit)) {
+            long id = std::atol(cell.c_str());
+            if (id < (long)n) return (int)id;
+        }
+        return -1;
+    };
+
+    std::string line;
+    if (!std::getline(in, line)) {
+        error = "empty file";
+        return false;
+    }
+    std::vector<std::string> header = split(line);
+    bool sparse = !header.empty() && header[0] == "origin";
+    std::vector<int> columns; // dense: station of each column
+    if (!sparse) {
+        for (size_t c = 1; c < header.size(); c++) {
+            columns.push_back(stationOf(header[c]));
+            if (columns.back() < 0) {
+                error = "unknown station '" + header[c] + "'";
+                return false;
+            }
+        }
+    }
+    int lineNumber = 1;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line == "\r") continue;
+        std::vector<std::string> cells = split(line);
+        int origin = cells.empty() ? -1 : stationOf(cells[0]);
+        if (origin < 0) {
+            error = "line " + std::to_string(lineNumber) + ": unknown origin";
+            return false;
+        }
+        if (sparse) {
+            int destination = cells.size() == 3 ? stationOf(cells[1]) : -1;
+            if (destination < 0) {
+                error = "line " + std::to_string(lineNumber) + ": expected origin,destination,trips";
+                return false;
+            }
+            double trips = std::atof(cells[2].c_str());
+            if (trips > 0 && origin != destination) demand.push_back({origin, destination, trips});
+        } else {
+            for (size_t c = 1; c < cells.size() && c - 1 < columns.size(); c++) {
+                double trips = std::atof(cells[c].c_str());
+                if (trips > 0 && origin != columns[c - 1]) demand.push_back({origin, columns[c - 1], trips});
+            }
+        }
+    }
+    return true;
+}
+
+bool OdStream::open(const std::string &path, const Graph &graph, std::string &error) {
+    if (!reader.open(path, error)) return false;
+    stations = (uint32_t)graph.stationNames.size();
+    carry.clear();
+    pos = size = 0;
+    uint32_t layout = 0, count = 0;
+    if (!reader.next(data, size, error) || size < 20 || std::memcmp(data, "ODM1", 4) != 0) {
+        error = "not a binary OD matrix: " + path;
+        return false;
+    }
+    std::memcpy(&layout, data + 4, sizeof(layout));
+    std::memcpy(&count, data + 8, sizeof(count));
+    std::memcpy(&remaining, data + 12, sizeof(remaining));
+    if (layout != 1 || count != stations) {
+        error = "streaming needs a sparse matrix over the graph's " + std::to_string(stations) + " stations";
+        return false;
+    }
+    pos = 20;
+    return true;
+}
+
+bool OdStream::next(std::vector<OdDemand> &out, size_t maxRecords, std::string &error) {
+    struct Record {
+        uint32_t origin, destination;
+        float trips;
+    };
+    error.clear();
+    out.clear();
+    while (out.size() < maxRecords && remaining > 0) {
+        if (pos == size) {
+            if (!reader.next(data, size, error)) {
+                if (error.empty()) error = "truncated sparse matrix";
+                return false;
+            }
+            pos = 0;
+        }
+        Record r;
+        if (!carry.empty() || size - pos < sizeof(Record)) {
+            size_t take = std::min(sizeof(Record) - carry.size(), size - pos);
+            carry.insert(carry.end(), data + pos, data + pos + take);
+            pos += take;
+            if (carry.size() < sizeof(Record)) continue;
+            std::memcpy(&r, carry.data(), sizeof(Record));
+            carry.clear();
+        } else {
+            std::memcpy(&r, data + pos, sizeof(Record));
+            pos += sizeof(Record);
+        }
+        remaining--;
+        if (r.origin >= stations || r.destination >= stations) {
+            error = "station ID out of range";
+            return false;
+        }
+        if (r.trips > 0 && r.origin != r.destination) out.push_back({(int)r.origin, (int)r.destination, r.trips});
+    }
+    return !out.empty();
+}
+
+FlowReport aggregateFlows(const GraphView &view, std::vector<OdDemand> demand, int transferCost,
+                          size_t lineCount, int walkingLine, int threads) {
+    std::sort(demand.begin(), demand.end(),
+              [](const OdDemand &a, const OdDemand &b) { return a.origin < b.origin; });
+    std::vector<size_t> originStarts;
+    for (size_t i = 0; i < demand.size(); i++) {
+        if (i == 0 || demand[i].origin != demand[i - 1].origin) originStarts.push_back(i);
+    }
+    originStarts.push_back(demand.size());
+    size_t groups = originStarts.size() - 1;
+    const size_t n = view.offsets.size() - 1;
+
+    threads = std::max(1, threads);
+    std::vector<FlowReport> partial(threads);
+    std::atomic<size_t> nextGroup(0);
+    auto worker = [&](int t) {
+        FlowReport &out = partial[t];
+        out.edgeFlow.assign(view.edges.size(), 0);
+        out.transfers.assign(n, 0);
+        out.boardings.assign(lineCount, 0);
+        SearchTree tree;
+        for (size_t g = nextGroup++; g < groups; g = nextGroup++) {
+            buildSearchTree(view, demand[originStarts[g]].origin, transferCost, tree);
+            for (size_t i = originStarts[g]; i < originStarts[g + 1]; i++) {
+                const OdDemand &od = demand[i];
+                if (od.origin == od.destination) continue;
+                if (tree.dist[od.destination] == std::numeric_limits<int>::max()) {
+                    out.unrouted += od.trips;
+                    continue;
+                }
+                // Walk back from the destination; 'nextLine' is the line leaving 'cur', and
+                // 'boardedLine' the last line boarded (at 'boardedAt') whose previous
+                // ride is still to be found. Walks in between are not rides, so a change
+                // through an interchange is one transfer, where the next line is boarded.
+                int nextLine = -1, boardedLine = -1, boardedAt = -1;
+                for (int cur = od.destination; cur != od.origin; cur = tree.parentStation[cur]) {
+                    const ViewEdge &edge = view.edges[tree.parentEdge[cur]];
+                    out.edgeFlow[tree.parentEdge[cur]] += od.trips;
+                    if (nextLine != -1 && nextLine != edge.lineId && nextLine != walkingLine) {
+                        out.boardings[nextLine] += od.trips;
+                        boardedLine = nextLine;
+                        boardedAt = cur;
+                    }
+                    if (edge.lineId != walkingLine && boardedLine != -1) {
+                        if (boardedLine != edge.lineId) out.transfers[boardedAt] += od.trips;
+                        boardedLine = -1;
+                    }
+                    nextLine = edge.lineId;
+                }
+                if (nextLine != walkingLine) out.boardings[nextLine] += od.trips;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto &t : pool) t.join();
+
+    FlowReport report = std::move(partial[0]);
+    for (int t = 1; t < threads; t++) {
+        for (size_t e = 0; e < report.edgeFlow.size(); e++) report.edgeFlow[e] += partial[t].edgeFlow[e];
+        for (size_t s = 0; s < n; s++) report.transfers[s] += partial[t].transfers[s];
+        for (size_t l = 0; l < lineCount; l++) report.boardings[l] += partial[t].boardings[l];
+        report.unrouted += partial[t].unrouted;
+    }
+    return report;
+}
+
+} // namespace subway
@@ -0,0 +1,370 @@
+#include "subway/graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "subway/colors.h"
+#include "subway/cost.h"
+#include "subway/path.h"
+
+namespace subway {
+
+int Graph::internStation(const std::string &station) {
+    auto it = stationIds.find(station);
+    if (it != stationIds.end()) return it->second;
+    stationIds[station] = (int)stationNames.size();
+    stationNames.push_back(station);
+    stationAttributes.push_back(0);
+    stationIndex = NameIndex();
+    return (int)stationNames.size() - 1;
+}
+
+int Graph::internLine(const std::string &line) {
+    auto it = lineIds.find(line);
+    if (it != lineIds.end()) return it->second;
+    lineIds[line] = (int)lineNames.size();
+    lineNames.push_back(line);
+    lineIndex = NameIndex();
+    return (int)lineNames.size() - 1;
+}
+
+void Graph::finalize() {
+    stationIndex.build(stationNames);
+    lineIndex.build(lineNames);
+}
+
+int Graph::findStation(std::string_view name) const {
+    if (stationIndex.size() == stationNames.size()) return stationIndex.find(name);
+    auto it = stationIds.find(std::string(name));
+    return it == stationIds.end() ? -1 : it->second;
+}
+
+int Graph::findLine(std::string_view name) const {
+    if (lineIndex.size() == lineNames.size()) return lineIndex.find(name);
+    auto it = lineIds.find(std::string(name));
+    return it == lineIds.end() ? -1 : it->second;
+}
+
+void Graph::addEdge(const std::string &from, const std::string &to, int cost, const std::string &line) {
+    internStation(from);
+    internStation(to);
+    adjList[from].push_back({to, cost, line, internLine(line), edgeCount++, 0});
+    views.clear();
+}
+
+void Graph::setStationAttributes(const std::string &station, uint8_t flags) {
+    stationAttributes[internStation(station)] = flags;
+    views.clear();
+}
+
+void Graph::setSegmentAttributes(const std::string &s1, const std::string &s2, const std::string &line, uint8_t flags) {
+    for (auto &edge : adjList[s1])
+        if (edge.destination == s2 && edge.line == line) edge.attributes = flags;
+    for (auto &edge : adjList[s2])
+        if (edge.destination == s1 && edge.line == line) edge.attributes = flags;
+    views.clear();
+}
+
+GraphView Graph::buildView(uint8_t mask) const {
+    GraphView view;
+    view.mask = mask;
+    view.offsets.assign(stationNames.size() + 1, 0);
+    for (size_t s = 0; s < stationNames.size(); s++) {
+        view.offsets[s] = (int)view.edges.size();
+        auto it = adjList.find(stationNames[s]);
+        if (it == adjList.end() || (stationAttributes[s] & mask)) continue;
+        for (const auto &edge : it->second) {
+            int to = findStation(edge.destination);
+            if ((edge.attributes & mask) || (stationAttributes[to] & mask)) continue;
+            view.edges.push_back({to, edge.cost, edge.lineId, edge.id});
+        }
+    }
+    view.offsets[stationNames.size()] = (int)view.edges.size();
+
+    // Incoming edges, grouped by destination.
+    view.reverseOffsets.assign(stationNames.size() + 1, 0);
+    for (const auto &edge : view.edges) view.reverseOffsets[edge.destination + 1]++;
+    for (size_t s = 0; s < stationNames.size(); s++) view.reverseOffsets[s + 1] += view.reverseOffsets[s];
+    view.reverseEdges.resize(view.edges.size());
+    std::vector<int> cursor(view.reverseOffsets.begin(), view.reverseOffsets.end() - 1);
+    for (size_t e = 0; e < view.edges.size(); e++) view.reverseEdges[cursor[view.edges[e].destination]++] = (int)e;
+    return view;
+}
+
+void Graph::prepareViews(const std::vector<uint8_t> &masks) {
+    for (uint8_t mask : masks) {
+        if (!views.count(mask)) views[mask] = buildView(mask);
+    }
+}
+
+const GraphView &Graph::view(uint8_t mask) {
+    auto it = views.find(mask);
+    if (it == views.end()) it = views.emplace(mask, buildView(mask)).first;
+    return it->second;
+}
+
+void Graph::addBidirectionalEdge(const std::string &s1, const std::string &s2, int cost, const std::string &line) {
+    addEdge(s1, s2, cost, line);
+    addEdge(s2, s1, cost, line);
+}
+
+std::pair<int, std::vector<std::pair<std::string, std::string>>> Graph::dijkstra(const std::string &source, const std::string &destination, int transferCost) {
+    // Distances from the source.
+    std::unordered_map<std::string, int> dist;
+    // For backtracking: map station -> {parent station, line used to get here}
+    std::unordered_map<std::string, std::pair<std::string, std::string>> parent;
+
+    // Initialize distances to "infinity".
+    for (auto &entry : adjList) {
+        dist[entry.first] = std::numeric_limits<int>::max();
+    }
+    dist[source] = 0;
+    // For source, no incoming line.
+    parent[source] = {"", ""};
+
+    // Node structure for the priority queue.
+    struct Node {
+        int cost;
+        std::string station;
+        std::string line; // current line used to get to this station.
+        bool operator>(const Node &other) const {
+            return cost > other.cost;
+        }
+    };
+
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> pq;
+    pq.push({0, source, ""});
+
+    while (!pq.empty()) {
+        Node current = pq.top();
+        pq.pop();
+        if (current.cost > dist[current.station])
+            continue;
+        if (current.station == destination)
+            break;
+        for (auto &edge : adjList[current.station]) {
+            int extra = 0;
+            // If already on a line and the edge's line is different, add transfer cost.
+            if (!current.line.empty() && current.line != edge.line)
+                extra = transferCost;
+            int newCost = CostTraits<int>::add(current.cost, edge.cost + extra);
+            if (newCost < dist[edge.destination]) {
+                dist[edge.destination] = newCost;
+                parent[edge.destination] = {current.station, edge.line};
+                pq.push({newCost, edge.destination, edge.line});
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, std::string>> fullPath;
+    if (dist[destination] == std::numeric_limits<int>::max()) {
+        return {-1, fullPath};  // destination unreachable.
+    }
+    // Reconstruct the path.
+    std::string cur = destination;
+    while (cur != source) {
+        fullPath.push_back({cur, parent[cur].second});
+        cur = parent[cur].first;
+    }
+    fullPath.push_back({source, ""}); // source has no incoming line.
+    std::reverse(fullPath.begin(), fullPath.end());
+    return {dist[destination], fullPath};
+}
+
+std::pair<int, std::vector<std::pair<std::string, std::string>>> Graph::dijkstra(const std::string &source, const std::string &destination,
+                                                                                 int transferCost, const GraphView &view,
+                                                                                 int prefetchDistance) {
+    std::vector<std::pair<std::string, std::string>> fullPath;
+    int src = findStation(source), dest = findStation(destination);
+    if (src < 0 || dest < 0 || (stationAttributes[src] & view.mask) || (stationAttributes[dest] & view.mask)) {
+        return {-1, fullPath};
+    }
+    PackedPath path = findPath(view, src, dest, transferCost, prefetchDistance);
+    if (path.cost == -1) {
+        return {-1, fullPath};
+    }
+    fullPath.push_back({source, ""});
+    for (int e : path.edges) {
+        const ViewEdge &edge = view.edges[e];
+        fullPath.push_back({stationNames[edge.destination], lineNames[edge.lineId]});
+    }
+    return {path.cost, fullPath};
+}
+
+FareModel Graph::makeFareModel(int baseFare, int transferWindow) const {
+    FareModel fares;
+    fares.baseFare = baseFare;
+    fares.transferWindow = transferWindow;
+    fares.surcharge.assign(lineNames.size(), 0);
+    fares.walking.assign(lineNames.size(), 0);
+    int walking = findLine("Interchange");
+    if (walking >= 0) fares.walking[walking] = 1;
+    return fares;
+}
+
+void FrequencyModel::setBands(int lineId, const std::vector<HeadwayBand> &lineBands) {
+    int begin = bandOffsets[lineId], end = bandOffsets[lineId + 1];
+    bands.erase(bands.begin() + begin, bands.begin() + end);
+    bands.insert(bands.begin() + begin, lineBands.begin(), lineBands.end());
+    std::sort(bands.begin() + begin, bands.begin() + begin + lineBands.size(),
+              [](const HeadwayBand &a, const HeadwayBand &b) { return a.start < b.start; });
+    int shift = (int)lineBands.size() - (end - begin);
+    for (size_t l = lineId + 1; l < bandOffsets.size(); l++) bandOffsets[l] += shift;
+}
+
+int FrequencyModel::headway(int lineId, int time) const {
+    const HeadwayBand *begin = bands.data() + bandOffsets[lineId], *end = bands.data() + bandOffsets[lineId + 1];
+    if (begin == end) return -1;
+    time = ((time % 1440) + 1440) % 1440;
+    const HeadwayBand *band = std::upper_bound(begin, end, time, [](int t, const HeadwayBand &b) { return t < b.start; });
+    return (band == begin ? end : band)[-1].headway;
+}
+
+int FrequencyModel::expectedWait(int lineId, int time) const {
+    int h = headway(lineId, time);
+    if (h == 0) return std::numeric_limits<int>::max();
+    return h < 0 ? 0 : (h + 1) / 2;
+}
+
+FrequencyModel Graph::makeFrequencyModel(int headway) const {
+    FrequencyModel frequencies;
+    int walking = findLine("Interchange");
+    frequencies.bandOffsets.push_back(0);
+    for (int l = 0; l < (int)lineNames.size(); l++) {
+        if (l != walking) frequencies.bands.push_back({0, (uint16_t)headway});
+        frequencies.bandOffsets.push_back((int)frequencies.bands.size());
+    }
+    return frequencies;
+}
+
+std::vector<FareRoute> Graph::fareAwareRoutes(const std::string &source, const std::string &destination,
+                                              int transferCost, const FareModel &fares, const GraphView &view) {
+    // The fare state is packed into one word: fare paid in the upper 20 bits,
+    // remaining transfer window in the lower 12 bits.
+    const uint32_t windowBits = 12;
+    const uint32_t windowMask = (1u << windowBits) - 1;
+    const int window = std::min(fares.transferWindow, (int)windowMask);
+
+    struct Label {
+        int time;
+        uint32_t state; // packed {fare, window left}
+        int lineId;     // line used to reach the station, -1 at the source
+        int parent;     // index of the previous label, -1 at the source
+        int station;
+        bool dead;
+    };
+    auto fareOf = [&](uint32_t state) { return (int)(state >> windowBits); };
+    auto windowOf = [&](uint32_t state) { return (int)(state & windowMask); };
+    // a dominates b when it is no worse in every criterion and can continue identically.
+    auto dominates = [&](const Label &a, const Label &b) {
+        return a.lineId == b.lineId && a.time <= b.time &&
+               fareOf(a.state) <= fareOf(b.state) && windowOf(a.state) >= windowOf(b.state);
+    };
+
+    std::vector<Label> labels;
+    std::vector<std::vector<int>> bags(stationNames.size()); // station -> live label indices
+    std::vector<int> targetLabels;
+
+    // Priority queue ordered lexicographically by (time, fare).
+    typedef std::pair<std::pair<int, int>, int> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+
+    auto insertLabel = [&](Label label) {
+        // Target pruning: a label no better than a found route cannot lead anywhere useful.
+        for (int t : targetLabels) {
+            if (labels[t].time <= label.time && fareOf(labels[t].state) <= fareOf(label.state))
+                return;
+        }
+        std::vector<int> &bag = bags[label.station];
+        for (int idx : bag) {
+            if (dominates(labels[idx], label)) return;
+        }
+        size_t kept = 0;
+        for (int idx : bag) {
+            if (dominates(label, labels[idx])) labels[idx].dead = true;
+            else bag[kept++] = idx;
+        }
+        bag.resize(kept);
+        label.dead = false;
+        labels.push_back(label);
+        bag.push_back((int)labels.size() - 1);
+        pq.push({{label.time, fareOf(label.state)}, (int)labels.size() - 1});
+    };
+
+    int src = findStation(source), dest = findStation(destination);
+    if (src < 0 || dest < 0 || (stationAttributes[src] & view.mask)) {
+        return {};
+    }
+    insertLabel({0, 0, -1, -1, src, false});
+
+    while (!pq.empty()) {
+        int idx = pq.top().second;
+        pq.pop();
+        if (labels[idx].dead) continue;
+        Label current = labels[idx];
+        if (current.station == dest) {
+            // Labels are settled in (time, fare) order, so a target label is
+            // Pareto-optimal exactly when it is cheaper than every route settled
+            // before it. Labels queued before the first route was found escaped
+            // the pruning in insertLabel and are dropped here.
+            if (targetLabels.empty() || fareOf(current.state) < fareOf(labels[targetLabels.back()].state))
+                targetLabels.push_back(idx);
+            continue;
+        }
+        int fare = fareOf(current.state);
+        int windowLeft = windowOf(current.state);
+        for (int e = view.offsets[current.station]; e < view.offsets[current.station + 1]; e++) {
+            const ViewEdge &edge = view.edges[e];
+            int extra = 0;
+            if (current.lineId != -1 && current.lineId != edge.lineId)
+                extra = transferCost;
+            int newFare = fare;
+            int newWindow = windowLeft;
+            bool boarding = current.lineId != edge.lineId && !fares.walking[edge.lineId];
+            if (boarding) {
+                if (windowLeft == 0) {
+                    newFare += fares.baseFare;
+                    newWindow = window;
+                }
+                newFare += fares.surcharge[edge.lineId];
+            }
+            newWindow = std::max(0, newWindow - edge.cost - extra);
+            uint32_t state = ((uint32_t)newFare << windowBits) | (uint32_t)newWindow;
+            insertLabel({CostTraits<int>::add(current.time, edge.cost + extra), state, edge.lineId, idx,
+                        edge.destination, false});
+        }
+    }
+
+    std::vector<FareRoute> routes;
+    for (int t : targetLabels) {
+        FareRoute route{labels[t].time, fareOf(labels[t].state), {}};
+        for (int cur = t; cur != -1; cur = labels[cur].parent) {
+            int line = labels[cur].lineId;
+            route.path.push_back({stationNames[labels[cur].station], line == -1 ? "" : lineNames[line]});
+        }
+        std::reverse(route.path.begin(), route.path.end());
+        routes.push_back(route);
+    }
+    return routes;
+}
+
+void Graph::displayMap() {
+    std::cout << "\nSubway Map:\n";
+    for (const auto &station : adjList) {
+        std::cout << station.first << ":\n";
+        for (const auto &edge : station.second) {
+            std::cout << "    -> " << edge.destination << " (" 
+                 << getColor(edge.line) << "Line " << edge.line << reset 
+                 << ", cost " << edge.cost << ")\n";
+        }
+        std::cout << "\n";
+    }
+}
+
+} // namespace subway
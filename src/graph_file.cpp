@@ -0,0 +1,268 @@
+#include "subway/graph_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace subway {
+
+// Version 2 adds the optional Trip-Based section; version 1 files still load.
+static const uint32_t kGraphFileVersion = 2;
+
+struct EdgeRecord {
+    uint32_t from, to, line;
+    int32_t cost;
+    uint32_t attributes;
+};
+
+template <class T>
+static void put(std::ofstream &out, const T &value) {
+    out.write((const char *)&value, sizeof(T));
+}
+
+template <class T>
+static void putVector(std::ofstream &out, const std::vector<T> &values) {
+    if (!values.empty()) out.write((const char *)values.data(), (std::streamsize)(values.size() * sizeof(T)));
+}
+
+static void putString(std::ofstream &out, const std::string &text) {
+    put(out, (uint32_t)text.size());
+    out.write(text.data(), (std::streamsize)text.size());
+}
+
+static void putIndex(std::ofstream &out, const NameIndex &index) {
+    put(out, index.hash.seed);
+    put(out, index.hash.slots);
+    put(out, (uint32_t)index.hash.pilots.size());
+    putVector(out, index.hash.pilots);
+    putVector(out, index.ids);
+    putVector(out, index.offsets);
+    putString(out, index.arena);
+}
+
+template <class T>
+static void putArray(std::ofstream &out, const std::vector<T> &values) {
+    put(out, (uint32_t)values.size());
+    putVector(out, values);
+}
+
+static void putTripBased(std::ofstream &out, const TripBased &tb) {
+    const Timetable &tt = tb.timetable;
+    put(out, (int32_t)tt.transferTime);
+    putArray(out, tt.routeLine);
+    putArray(out, tt.routeStopOffsets);
+    putArray(out, tt.routeStops);
+    putArray(out, tt.routeTripOffsets);
+    putArray(out, tt.tripRoute);
+    putArray(out, tt.tripEventOffsets);
+    putArray(out, tt.arrival);
+    putArray(out, tt.departure);
+    putArray(out, tt.stationStopOffsets);
+    putArray(out, tt.stationStops);
+    putArray(out, tt.footpathOffsets);
+    putArray(out, tt.footpaths);
+    putArray(out, tb.transferOffsets);
+    putArray(out, tb.transfers);
+}
+
+template <class T>
+static bool get(std::ifstream &in, T &value) {
+    return (bool)in.read((char *)&value, sizeof(T));
+}
+
+template <class T>
+static bool getVector(std::ifstream &in, std::vector<T> &values, uint64_t count) {
+    // Sanity bound: no section of a graph file holds a billion entries.
+    if (count > (1u << 30)) return false;
+    values.resize((size_t)count);
+    return count == 0 || (bool)in.read((char *)values.data(), (std::streamsize)(count * sizeof(T)));
+}
+
+template <class T>
+static bool getArray(std::ifstream &in, std::vector<T> &values) {
+    uint32_t count = 0;
+    return get(in, count) && getVector(in, values, count);
+}
+
+// CSR offsets: 'groups' + 1 non-decreasing entries from 0 to 'total'.
+static bool validOffsets(const std::vector<int> &offsets, size_t groups, size_t total) {
+    if (offsets.size() != groups + 1 || offsets.front() != 0 || (size_t)offsets.back() != total) return false;
+    for (size_t i = 0; i < groups; i++)
+        if (offsets[i] > offsets[i + 1]) return false;
+    return true;
+}
+
+static bool getTripBased(std::ifstream &in, TripBased &tb, size_t stations) {
+    Timetable &tt = tb.timetable;
+    int32_t transferTime = 0;
+    if (!get(in, transferTime) || !getArray(in, tt.routeLine) || !getArray(in, tt.routeStopOffsets) ||
+        !getArray(in, tt.routeStops) || !getArray(in, tt.routeTripOffsets) || !getArray(in, tt.tripRoute) ||
+        !getArray(in, tt.tripEventOffsets) || !getArray(in, tt.arrival) || !getArray(in, tt.departure) ||
+        !getArray(in, tt.stationStopOffsets) || !getArray(in, tt.stationStops) ||
+        !getArray(in, tt.footpathOffsets) || !getArray(in, tt.footpaths) || !getArray(in, tb.transferOffsets) ||
+        !getArray(in, tb.transfers))
+        return false;
+    tt.transferTime = transferTime;
+    const size_t routes = tt.routeLine.size(), trips = tt.tripRoute.size(), events = tt.arrival.size();
+    if (!validOffsets(tt.routeStopOffsets, routes, tt.routeStops.size()) ||
+        !validOffsets(tt.routeTripOffsets, routes, trips) || !validOffsets(tt.tripEventOffsets, trips, events) ||
+        tt.departure.size() != events || !validOffsets(tt.stationStopOffsets, stations, tt.stationStops.size()) ||
+        !validOffsets(tt.footpathOffsets, stations, tt.footpaths.size()) ||
+        !validOffsets(tb.transferOffsets, events, tb.transfers.size()))
+        return false;
+    for (int s : tt.routeStops)
+        if (s < 0 || (size_t)s >= stations) return false;
+    for (size_t r = 0; r < routes; r++) {
+        for (int t = tt.routeTripOffsets[r]; t < tt.routeTripOffsets[r + 1]; t++) {
+            if (tt.tripRoute[t] != (int)r || tt.tripEventOffsets[t + 1] - tt.tripEventOffsets[t] != tt.stopCount((int)r))
+                return false;
+        }
+    }
+    for (const auto &[route, stop] : tt.stationStops)
+        if (route < 0 || (size_t)route >= routes || stop < 0 || stop >= tt.stopCount(route)) return false;
+    for (const Footpath &walk : tt.footpaths)
+        if (walk.to < 0 || (size_t)walk.to >= stations) return false;
+    for (const TripTransfer &transfer : tb.transfers) {
+        if (transfer.trip < 0 || (size_t)transfer.trip >= trips || transfer.stop < 0 ||
+            transfer.stop >= tt.stopCount(tt.tripRoute[transfer.trip]))
+            return false;
+    }
+    return true;
+}
+
+static bool getString(std::ifstream &in, std::string &text) {
+    uint32_t length = 0;
+    if (!get(in, length) || length > (1u << 30)) return false;
+    text.resize(length);
+    return length == 0 || (bool)in.read(&text[0], length);
+}
+
+static bool getIndex(std::ifstream &in, NameIndex &index, size_t names) {
+    uint32_t pilotCount = 0;
+    if (!get(in, index.hash.seed) || !get(in, index.hash.slots) || !get(in, pilotCount) ||
+        index.hash.slots != names || pilotCount == 0)
+        return false;
+    if (!getVector(in, index.hash.pilots, pilotCount) || !getVector(in, index.ids, names) ||
+        !getVector(in, index.offsets, names + 1) || !getString(in, index.arena))
+        return false;
+    if (index.offsets.front() != 0 || index.offsets.back() != index.arena.size()) return false;
+    for (size_t s = 0; s < names; s++)
+        if (index.offsets[s] > index.offsets[s + 1] || index.ids[s] >= names) return false;
+    return true;
+}
+
+bool saveGraph(Graph &graph, const std::string &path, std::string &error, const TripBased *tripBased) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        error = "cannot create " + path;
+        return false;
+    }
+    graph.finalize();
+    std::vector<EdgeRecord> edges(graph.edgeCount);
+    for (size_t s = 0; s < graph.stationNames.size(); s++) {
+        auto it = graph.adjList.find(graph.stationNames[s]);
+        if (it == graph.adjList.end()) continue;
+        for (const auto &edge : it->second) {
+            edges[edge.id] = {(uint32_t)s, (uint32_t)graph.findStation(edge.destination), (uint32_t)edge.lineId,
+                              edge.cost, edge.attributes};
+        }
+    }
+
+    out.write("SGF1", 4);
+    put(out, kGraphFileVersion);
+    put(out, (uint32_t)graph.stationNames.size());
+    for (const auto &name : graph.stationNames) putString(out, name);
+    putVector(out, graph.stationAttributes);
+    put(out, (uint32_t)graph.lineNames.size());
+    for (const auto &name : graph.lineNames) putString(out, name);
+    put(out, (uint32_t)edges.size());
+    putVector(out, edges);
+    putIndex(out, graph.stationIndex);
+    putIndex(out, graph.lineIndex);
+    put(out, (uint32_t)(tripBased != nullptr));
+    if (tripBased) putTripBased(out, *tripBased);
+    if (!out) {
+        error = "write failed: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool loadGraph(Graph &graph, const std::string &path, std::string &error, TripBased *tripBased) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    uint32_t version = 0;
+    if (!in.read(magic, 4) || std::memcmp(magic, "SGF1", 4) != 0 || !get(in, version) ||
+        version < 1 || version > kGraphFileVersion) {
+        error = "not an SGF1 graph file: " + path;
+        return false;
+    }
+    graph = Graph();
+    uint32_t stations = 0, lines = 0, edgeCount = 0;
+    std::string name;
+    bool ok = get(in, stations);
+    for (uint32_t s = 0; ok && s < stations; s++) {
+        ok = getString(in, name);
+        if (ok) graph.internStation(name);
+    }
+    std::vector<uint8_t> attributes;
+    ok = ok && getVector(in, attributes, stations) && get(in, lines);
+    for (uint32_t l = 0; ok && l < lines; l++) {
+        ok = getString(in, name);
+        if (ok) graph.internLine(name);
+    }
+    std::vector<EdgeRecord> edges;
+    ok = ok && graph.stationNames.size() == stations && graph.lineNames.size() == lines && get(in, edgeCount) &&
+         getVector(in, edges, edgeCount);
+    if (!ok) {
+        error = "truncated or corrupt graph file";
+        return false;
+    }
+    for (const EdgeRecord &edge : edges) {
+        if (edge.from >= stations || edge.to >= stations || edge.line >= lines) {
+            error = "edge refers to an unknown station or line";
+            return false;
+        }
+        const std::string &from = graph.stationNames[edge.from];
+        graph.addEdge(from, graph.stationNames[edge.to], edge.cost, graph.lineNames[edge.line]);
+        graph.adjList[from].back().attributes = (uint8_t)edge.attributes;
+    }
+    graph.stationAttributes = attributes;
+
+    // The indexes are read last: registering names above drops them.
+    if (!getIndex(in, graph.stationIndex, stations) || !getIndex(in, graph.lineIndex, lines)) {
+        error = "corrupt name index";
+        return false;
+    }
+    for (uint32_t s = 0; s < stations; s++) {
+        if (graph.stationIndex.find(graph.stationNames[s]) != (int)s) {
+            error = "station index does not match the station names";
+            return false;
+        }
+    }
+    for (uint32_t l = 0; l < lines; l++) {
+        if (graph.lineIndex.find(graph.lineNames[l]) != (int)l) {
+            error = "line index does not match the line names";
+            return false;
+        }
+    }
+
+    uint32_t hasTrips = 0;
+    if (version >= 2 && !get(in, hasTrips)) {
+        error = "truncated graph file";
+        return false;
+    }
+    if (tripBased) {
+        *tripBased = TripBased();
+        if (hasTrips && !getTripBased(in, *tripBased, stations)) {
+            error = "corrupt Trip-Based section";
+            *tripBased = TripBased();
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace subway
@@ -0,0 +1,188 @@
+#include "subway/interleave.h"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "subway/cost.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define SUBWAY_HAVE_COROUTINES 1
+#endif
+
+namespace subway {
+
+namespace {
+
+typedef std::pair<int, int> QueueEntry; // {cost, station}
+
+// Per-query search state, reused across queries; only touched entries are reset.
+struct QueryState {
+    std::vector<int> dist;
+    std::vector<int> arrivalLine;
+    std::vector<int> touched;
+    std::vector<QueueEntry> heap;
+
+    explicit QueryState(size_t n) : dist(n, std::numeric_limits<int>::max()), arrivalLine(n, -1) {}
+
+    void reset() {
+        for (int s : touched) {
+            dist[s] = std::numeric_limits<int>::max();
+            arrivalLine[s] = -1;
+        }
+        touched.clear();
+        heap.clear();
+    }
+
+    void push(int cost, int station) {
+        heap.push_back({cost, station});
+        std::push_heap(heap.begin(), heap.end(), std::greater<QueueEntry>());
+    }
+
+    QueueEntry pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<QueueEntry>());
+        QueueEntry top = heap.back();
+        heap.pop_back();
+        return top;
+    }
+};
+
+// Relaxes the edges of 'station' at 'cost'.
+inline void relax(const GraphView &view, QueryState &state, int station, int cost, int transferCost) {
+    for (int e = view.offsets[station]; e < view.offsets[station + 1]; e++) {
+        const ViewEdge &edge = view.edges[e];
+        int extra = 0;
+        if (state.arrivalLine[station] != -1 && state.arrivalLine[station] != edge.lineId)
+            extra = transferCost;
+        int newCost = CostTraits<int>::add(cost, edge.cost + extra);
+        if (newCost < state.dist[edge.destination]) {
+            if (state.dist[edge.destination] == std::numeric_limits<int>::max())
+                state.touched.push_back(edge.destination);
+            state.dist[edge.destination] = newCost;
+            state.arrivalLine[edge.destination] = edge.lineId;
+            state.push(newCost, edge.destination);
+        }
+    }
+}
+
+int plainQuery(const GraphView &view, QueryState &state, int source, int target, int transferCost) {
+    state.reset();
+    state.dist[source] = 0;
+    state.touched.push_back(source);
+    state.push(0, source);
+    while (!state.heap.empty()) {
+        auto [cost, station] = state.pop();
+        if (cost > state.dist[station]) continue;
+        if (station == target) break;
+        relax(view, state, station, cost, transferCost);
+    }
+    int cost = state.dist[target];
+    return cost == std::numeric_limits<int>::max() ? -1 : cost;
+}
+
+#ifdef SUBWAY_HAVE_COROUTINES
+
+// Coroutine running one query. It starts suspended and is resumed by the
+// scheduler; 'result' is valid once the handle is done.
+struct QueryTask {
+    struct promise_type {
+        int result = -1;
+        QueryTask get_return_object() {
+            return QueryTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(int cost) { result = cost; }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+QueryTask interleavedQuery(const GraphView &view, QueryState &state, int source, int target, int transferCost) {
+    state.reset();
+    state.dist[source] = 0;
+    state.touched.push_back(source);
+    state.push(0, source);
+    while (!state.heap.empty()) {
+        auto [cost, station] = state.pop();
+        if (cost > state.dist[station]) continue;
+        if (station == target) break;
+        // The edge range of a newly settled station is usually cold.
+        int begin = view.offsets[station], end = view.offsets[station + 1];
+        __builtin_prefetch(view.edges.data() + begin);
+        if (end > begin) __builtin_prefetch(view.edges.data() + end - 1);
+        co_await std::suspend_always{};
+        // Then the distance entries of the neighbours, which are random accesses.
+        for (int e = begin; e < end; e++) __builtin_prefetch(&state.dist[view.edges[e].destination], 1);
+        co_await std::suspend_always{};
+        relax(view, state, station, cost, transferCost);
+    }
+    int result = state.dist[target];
+    co_return result == std::numeric_limits<int>::max() ? -1 : result;
+}
+
+#endif
+
+} // namespace
+
+bool interleavingAvailable() {
+#ifdef SUBWAY_HAVE_COROUTINES
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::vector<int> interleavedCosts(const GraphView &view, const std::vector<std::pair<int, int>> &queries,
+                                  int transferCost, int group) {
+    const size_t n = view.offsets.size() - 1;
+    std::vector<int> costs(queries.size(), -1);
+#ifdef SUBWAY_HAVE_COROUTINES
+    if (group > 1) {
+        // Round-robin over 'group' slots; a slot whose query finished takes the next one.
+        struct Slot {
+            QueryState state;
+            std::coroutine_handle<QueryTask::promise_type> handle;
+            size_t query = 0;
+            explicit Slot(size_t n) : state(n) {}
+        };
+        std::vector<Slot> slots;
+        slots.reserve(group);
+        size_t next = 0, active = 0;
+        for (int g = 0; g < group; g++) slots.emplace_back(n);
+        auto start = [&](Slot &slot) {
+            if (next == queries.size()) return false;
+            slot.query = next++;
+            slot.handle = interleavedQuery(view, slot.state, queries[slot.query].first, queries[slot.query].second,
+                                           transferCost)
+                              .handle;
+            return true;
+        };
+        for (auto &slot : slots)
+            if (start(slot)) active++;
+        while (active > 0) {
+            for (auto &slot : slots) {
+                if (!slot.handle) continue;
+                slot.handle.resume();
+                if (!slot.handle.done()) continue;
+                costs[slot.query] = slot.handle.promise().result;
+                slot.handle.destroy();
+                slot.handle = nullptr;
+                if (!start(slot)) active--;
+            }
+        }
+        return costs;
+    }
+#endif
+    (void)group;
+    QueryState state(n);
+    for (size_t q = 0; q < queries.size(); q++)
+        costs[q] = plainQuery(view, state, queries[q].first, queries[q].second, transferCost);
+    return costs;
+}
+
+} // namespace subway
@@ -0,0 +1,226 @@
+#include "subway/path.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <tuple>
+
+#include "subway/cost.h"
+#include "subway/search_tree.h"
+
+namespace subway {
+
+void ShapeStore::setShape(int edgeId, const std::vector<ShapePoint> &shape) {
+    if ((int)runs.size() <= edgeId) runs.resize(edgeId + 1);
+    Run &run = runs[edgeId];
+    run.offset = (uint32_t)points.size();
+    run.count = (uint32_t)shape.size();
+    run.reversed = 0;
+    points.insert(points.end(), shape.begin(), shape.end());
+}
+
+void ShapeStore::shareReversed(int edgeId, int other) {
+    if ((int)runs.size() <= edgeId) runs.resize(edgeId + 1);
+    runs[edgeId] = runs[other];
+    runs[edgeId].reversed = !runs[other].reversed;
+}
+
+bool ShapeStore::hasShape(int edgeId) const {
+    return edgeId < (int)runs.size() && runs[edgeId].count > 0;
+}
+
+void ShapeStore::appendShape(int edgeId, std::vector<ShapePoint> &out) const {
+    if (!hasShape(edgeId)) return;
+    const Run &run = runs[edgeId];
+    for (uint32_t i = 0; i < run.count; i++) {
+        const ShapePoint &p = points[run.offset + (run.reversed ? run.count - 1 - i : i)];
+        if (i == 0 && !out.empty() && out.back().lat == p.lat && out.back().lon == p.lon) continue;
+        out.push_back(p);
+    }
+}
+
+ShapeStore buildStationShapes(const Graph &graph, const std::vector<ShapePoint> &stationCoords) {
+    ShapeStore shapes;
+    // Edge ID of the first direction seen for each {from, to, line}.
+    std::map<std::tuple<int, int, int>, int> seen;
+    for (size_t s = 0; s < graph.stationNames.size(); s++) {
+        auto it = graph.adjList.find(graph.stationNames[s]);
+        if (it == graph.adjList.end()) continue;
+        for (const auto &edge : it->second) {
+            int from = (int)s, to = graph.findStation(edge.destination);
+            auto reverse = seen.find({to, from, edge.lineId});
+            if (reverse != seen.end()) {
+                shapes.shareReversed(edge.id, reverse->second);
+            } else {
+                shapes.setShape(edge.id, {stationCoords[from], stationCoords[to]});
+                seen[{from, to, edge.lineId}] = edge.id;
+            }
+        }
+    }
+    return shapes;
+}
+
+// Shared search of findPath and findRoute. Fills 'dist' and 'parentEdge' (positions in
+// view.edges) and stops once 'destination' is settled. With prefetchDistance > 0 the
+// relaxation loop prefetches the distance entry 'prefetchDistance' edges ahead, and
+// the edge range of the station at the top of the queue before relaxing the current one.
+// With 'frequencies', boarding a line adds its expected wait at 'departure' + cost.
+static void searchPath(const GraphView &view, int source, int destination, int transferCost,
+                       std::vector<int> &dist, std::vector<int> &parentEdge, int prefetchDistance = 0,
+                       const FrequencyModel *frequencies = nullptr, int departure = 0) {
+    const int n = (int)view.offsets.size() - 1;
+    dist.assign(n, std::numeric_limits<int>::max());
+    parentEdge.assign(n, -1);
+    std::vector<int> arrivalLine(n, -1);
+    dist[source] = 0;
+
+    typedef std::pair<int, int> QueueEntry; // {cost, station}
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+    pq.push({0, source});
+    while (!pq.empty()) {
+        auto [cost, station] = pq.top();
+        pq.pop();
+        if (cost > dist[station])
+            continue;
+        if (station == destination)
+            break;
+        const int begin = view.offsets[station], end = view.offsets[station + 1];
+        if (prefetchDistance > 0) {
+            if (!pq.empty()) __builtin_prefetch(view.edges.data() + view.offsets[pq.top().second]);
+            for (int e = begin; e < end && e < begin + prefetchDistance; e++)
+                __builtin_prefetch(&dist[view.edges[e].destination], 1);
+        }
+        for (int e = begin; e < end; e++) {
+            if (prefetchDistance > 0 && e + prefetchDistance < end)
+                __builtin_prefetch(&dist[view.edges[e + prefetchDistance].destination], 1);
+            const ViewEdge &edge = view.edges[e];
+            int extra = 0;
+            if (arrivalLine[station] != -1 && arrivalLine[station] != edge.lineId)
+                extra = transferCost;
+            if (frequencies && arrivalLine[station] != edge.lineId) {
+                int wait = frequencies->expectedWait(edge.lineId, departure + cost + extra);
+                if (wait == std::numeric_limits<int>::max()) continue;
+                extra += wait;
+            }
+            int newCost = CostTraits<int>::add(cost, edge.cost + extra);
+            if (newCost < dist[edge.destination]) {
+                dist[edge.destination] = newCost;
+                parentEdge[edge.destination] = e;
+                arrivalLine[edge.destination] = edge.lineId;
+                pq.push({newCost, edge.destination});
+            }
+        }
+    }
+}
+
+// Packs the path to 'destination' recorded in 'dist'/'parentEdge'. With 'waits', the
+// expected wait of each boarding is recovered from the costs: what a boarding edge
+// adds beyond its own cost and the transfer penalty.
+static PackedPath packPath(const GraphView &view, const std::vector<int> &dist, const std::vector<int> &parentEdge,
+                           int source, int destination, bool waits = false, int transferCost = 0) {
+    PackedPath path;
+    path.source = source;
+    if (dist[destination] == std::numeric_limits<int>::max()) return path;
+    path.cost = dist[destination];
+    for (int cur = destination; cur != source; cur = edgeSource(view, parentEdge[cur])) {
+        path.edges.push_back(parentEdge[cur]);
+    }
+    std::reverse(path.edges.begin(), path.edges.end());
+    if (waits) {
+        int station = source, line = -1;
+        for (int e : path.edges) {
+            const ViewEdge &edge = view.edges[e];
+            if (edge.lineId != line) {
+                int penalty = line == -1 ? 0 : transferCost;
+                path.waits.push_back(dist[edge.destination] - dist[station] - edge.cost - penalty);
+                line = edge.lineId;
+            }
+            station = edge.destination;
+        }
+    }
+    return path;
+}
+
+PackedPath findPath(const GraphView &view, int source, int destination, int transferCost, int prefetchDistance) {
+    std::vector<int> dist, parentEdge;
+    searchPath(view, source, destination, transferCost, dist, parentEdge, prefetchDistance);
+    return packPath(view, dist, parentEdge, source, destination);
+}
+
+PackedPath findPath(const GraphView &view, int source, int destination, int transferCost,
+                    const FrequencyModel &frequencies, int departure) {
+    std::vector<int> dist, parentEdge;
+    searchPath(view, source, destination, transferCost, dist, parentEdge, 0, &frequencies, departure);
+    return packPath(view, dist, parentEdge, source, destination, true, transferCost);
+}
+
+// Summarizes the path to 'destination' recorded in 'dist'/'parentEdge' into legs,
+// walking back from the destination and opening a leg at each line change.
+static Route collectRoute(const GraphView &view, const std::vector<int> &dist, const std::vector<int> &parentEdge,
+                          int source, int destination) {
+    Route route;
+    if (dist[destination] == std::numeric_limits<int>::max()) return route;
+    route.cost = dist[destination];
+    for (int cur = destination; cur != source;) {
+        const ViewEdge &edge = view.edges[parentEdge[cur]];
+        if (route.legs.empty() || route.legs.back().lineId != edge.lineId) {
+            route.legs.push_back({cur, cur, edge.lineId, 0, 0});
+        }
+        cur = edgeSource(view, parentEdge[cur]);
+        RouteLeg &leg = route.legs.back();
+        leg.board = cur;
+        leg.stops++;
+    }
+    std::reverse(route.legs.begin(), route.legs.end());
+    for (RouteLeg &leg : route.legs) leg.cost = dist[leg.alight] - dist[leg.board];
+    return route;
+}
+
+Route findRoute(const GraphView &view, int source, int destination, int transferCost) {
+    std::vector<int> dist, parentEdge;
+    searchPath(view, source, destination, transferCost, dist, parentEdge);
+    return collectRoute(view, dist, parentEdge, source, destination);
+}
+
+Route findRoute(const GraphView &view, int source, int destination, int transferCost,
+                const FrequencyModel &frequencies, int departure) {
+    std::vector<int> dist, parentEdge;
+    searchPath(view, source, destination, transferCost, dist, parentEdge, 0, &frequencies, departure);
+    return collectRoute(view, dist, parentEdge, source, destination);
+}
+
+Route treeRoute(const GraphView &view, const SearchTree &tree, int destination) {
+    return collectRoute(view, tree.dist, tree.parentEdge, tree.source, destination);
+}
+
+std::vector<PathLeg> unpackPath(const GraphView &view, const PackedPath &path, int transferCost,
+                                const ShapeStore *shapes) {
+    std::vector<PathLeg> legs;
+    int station = path.source, total = 0;
+    for (int e : path.edges) {
+        const ViewEdge &edge = view.edges[e];
+        if (legs.empty() || legs.back().lineId != edge.lineId) {
+            PathLeg leg;
+            leg.lineId = edge.lineId;
+            leg.transferPenalty = legs.empty() ? 0 : transferCost;
+            if (legs.size() < path.waits.size()) leg.wait = path.waits[legs.size()];
+            total += leg.transferPenalty + leg.wait;
+            leg.stations.push_back(station);
+            leg.cumulativeCosts.push_back(total);
+            legs.push_back(std::move(leg));
+        }
+        PathLeg &leg = legs.back();
+        total += edge.cost;
+        leg.stations.push_back(edge.destination);
+        leg.edgeIds.push_back(edge.edgeId);
+        leg.segmentCosts.push_back(edge.cost);
+        leg.cumulativeCosts.push_back(total);
+        if (shapes) shapes->appendShape(edge.edgeId, leg.geometry);
+        station = edge.destination;
+    }
+    return legs;
+}
+
+} // namespace subway
@@ -0,0 +1,107 @@
+#include "subway/perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#define SUBWAY_HAVE_PERF_EVENTS 1
+#endif
+
+namespace subway {
+
+const char *perfEventName(PerfEvent event) {
+    switch (event) {
+    case PERF_TASK_CLOCK: return "task-clock";
+    case PERF_CYCLES: return "cycles";
+    case PERF_INSTRUCTIONS: return "instructions";
+    case PERF_L1D_MISSES: return "L1d-misses";
+    case PERF_LLC_MISSES: return "LLC-misses";
+    case PERF_BRANCH_MISSES: return "branch-misses";
+    default: return "unknown";
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+#ifdef SUBWAY_HAVE_PERF_EVENTS
+
+static int openEvent(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+bool PerfCounters::open(std::string &error) {
+    close();
+    const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    fds[PERF_TASK_CLOCK] = openEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+    fds[PERF_CYCLES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[PERF_INSTRUCTIONS] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[PERF_L1D_MISSES] = openEvent(PERF_TYPE_HW_CACHE, l1dReadMiss);
+    fds[PERF_LLC_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fds[PERF_BRANCH_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    for (int fd : fds)
+        if (fd >= 0) return true;
+    error = std::string("perf_event_open: ") + std::strerror(errno);
+    return false;
+}
+
+void PerfCounters::start() {
+    for (int fd : fds) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfReading PerfCounters::stop() {
+    PerfReading reading;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (fds[e] >= 0) ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        uint64_t value = 0;
+        if (fds[e] >= 0 && read(fds[e], &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+            reading.valid[e] = true;
+            reading.value[e] = value;
+        }
+    }
+    return reading;
+}
+
+#else
+
+bool PerfCounters::open(std::string &error) {
+    error = "perf_event_open is not available on this platform";
+    return false;
+}
+
+void PerfCounters::start() {}
+
+PerfReading PerfCounters::stop() {
+    return PerfReading();
+}
+
+#endif
+
+void PerfCounters::close() {
+    for (int &fd : fds) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace subway
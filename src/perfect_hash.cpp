@@ -0,0 +1,128 @@
+#include "subway/perfect_hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace subway {
+
+uint64_t hashName(std::string_view key, uint64_t seed) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    const size_t len = key.size();
+    uint64_t h = seed ^ (len * m);
+    const char *data = key.data();
+    const char *end = data + (len / 8) * 8;
+    for (; data != end; data += 8) {
+        uint64_t k;
+        std::memcpy(&k, data, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    const unsigned char *tail = (const unsigned char *)data;
+    switch (len & 7) {
+    case 7: h ^= uint64_t(tail[6]) << 48; [[fallthrough]];
+    case 6: h ^= uint64_t(tail[5]) << 40; [[fallthrough]];
+    case 5: h ^= uint64_t(tail[4]) << 32; [[fallthrough]];
+    case 4: h ^= uint64_t(tail[3]) << 24; [[fallthrough]];
+    case 3: h ^= uint64_t(tail[2]) << 16; [[fallthrough]];
+    case 2: h ^= uint64_t(tail[1]) << 8; [[fallthrough]];
+    case 1:
+        h ^= uint64_t(tail[0]);
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+bool PerfectHash::build(const std::vector<std::string_view> &keys) {
+    const uint64_t n = keys.size();
+    slots = n;
+    pilots.assign(1, 0);
+    if (n == 0) return true;
+    // About four keys per bucket: small enough that pilots are found quickly,
+    // large enough that the pilot table stays at one word per four keys.
+    const uint32_t bucketCount = (uint32_t)std::max<uint64_t>(1, (n + 3) / 4);
+    const uint32_t maxPilot = 1u << 24;
+
+    std::vector<uint64_t> hashes(n);
+    std::vector<uint32_t> bucketOf(n), order(n), bucketStart(bucketCount + 1), bucketOrder(bucketCount);
+    std::vector<char> taken(n);
+    std::vector<uint32_t> positions;
+    for (seed = 0x5ab1e5eedULL;; seed++) {
+        for (uint64_t i = 0; i < n; i++) {
+            hashes[i] = hashName(keys[i], seed);
+            bucketOf[i] = (uint32_t)(hashes[i] >> 32) % bucketCount;
+        }
+        // Equal hashes can never be separated by a pilot: identical keys are an
+        // error, a genuine collision needs another seed.
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return hashes[a] < hashes[b]; });
+        bool collision = false;
+        for (uint64_t i = 1; i < n; i++) {
+            if (hashes[order[i]] != hashes[order[i - 1]]) continue;
+            if (keys[order[i]] == keys[order[i - 1]]) return false;
+            collision = true;
+        }
+        if (collision) continue;
+
+        // Keys grouped by bucket; buckets placed largest first.
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return bucketOf[a] < bucketOf[b]; });
+        std::fill(bucketStart.begin(), bucketStart.end(), 0);
+        for (uint64_t i = 0; i < n; i++) bucketStart[bucketOf[i] + 1]++;
+        for (uint32_t b = 0; b < bucketCount; b++) bucketStart[b + 1] += bucketStart[b];
+        std::iota(bucketOrder.begin(), bucketOrder.end(), 0u);
+        std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](uint32_t a, uint32_t b) {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+        pilots.assign(bucketCount, 0);
+        std::fill(taken.begin(), taken.end(), 0);
+        bool placed = true;
+        for (uint32_t b : bucketOrder) {
+            if (bucketStart[b] == bucketStart[b + 1]) break;
+            uint32_t pilot = 0;
+            for (; pilot < maxPilot; pilot++) {
+                positions.clear();
+                uint64_t mixed = mixPilot(pilot);
+                bool fits = true;
+                for (uint32_t k = bucketStart[b]; k < bucketStart[b + 1] && fits; k++) {
+                    uint32_t pos = slotOf(hashes[order[k]], mixed, n);
+                    fits = !taken[pos] && std::find(positions.begin(), positions.end(), pos) == positions.end();
+                    positions.push_back(pos);
+                }
+                if (fits) break;
+            }
+            if (pilot == maxPilot) {
+                placed = false;
+                break;
+            }
+            pilots[b] = pilot;
+            for (uint32_t pos : positions) taken[pos] = 1;
+        }
+        if (placed) return true;
+    }
+}
+
+bool NameIndex::build(const std::vector<std::string> &names) {
+    std::vector<std::string_view> keys(names.begin(), names.end());
+    if (!hash.build(keys)) return false;
+    const size_t n = names.size();
+    std::vector<uint32_t> nameOfSlot(n);
+    for (size_t i = 0; i < n; i++) nameOfSlot[hash(keys[i])] = (uint32_t)i;
+    ids.assign(nameOfSlot.begin(), nameOfSlot.end());
+    offsets.assign(1, 0);
+    arena.clear();
+    for (size_t s = 0; s < n; s++) {
+        arena += names[ids[s]];
+        offsets.push_back((uint32_t)arena.size());
+    }
+    return true;
+}
+
+} // namespace subway
@@ -0,0 +1,240 @@
+#include "subway/query_parser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SUBWAY_HAVE_X86_SIMD 1
+#endif
+
+namespace subway {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string &path, std::string &error) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        error = "cannot open " + path;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    length = (size_t)info.st_size;
+    if (length > 0) {
+        void *map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            error = "cannot map " + path;
+            return false;
+        }
+        madvise(map, length, MADV_SEQUENTIAL);
+        bytes = (const char *)map;
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap((void *)bytes, length);
+    bytes = nullptr;
+    length = 0;
+}
+
+SimdLevel bestSimdLevel() {
+#ifdef SUBWAY_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+const char *simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SIMD_AVX2: return "AVX2";
+    case SIMD_SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
+
+// The scanners call visit(offset) for every ',' and '\n' in order and stop early
+// when it returns false. The SIMD versions build a 64-bit mask per 64 bytes and
+// walk its set bits; visit is inlined into each of them.
+template <class Visit>
+static inline bool scanScalar(const char *data, size_t from, size_t size, Visit &visit) {
+    for (size_t i = from; i < size; i++)
+        if ((data[i] == ',' || data[i] == '\n') && !visit((uint32_t)i)) return false;
+    return true;
+}
+
+template <class Visit>
+static inline bool visitBits(uint64_t mask, size_t base, Visit &visit) {
+    while (mask) {
+        if (!visit((uint32_t)(base + (size_t)__builtin_ctzll(mask)))) return false;
+        mask &= mask - 1;
+    }
+    return true;
+}
+
+#ifdef SUBWAY_HAVE_X86_SIMD
+
+template <class Visit>
+__attribute__((target("sse2"))) static bool scanSse2(const char *data, size_t size, Visit &visit) {
+    const __m128i comma = _mm_set1_epi8(','), newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        uint64_t mask = 0;
+        for (int part = 0; part < 4; part++) {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i + 16 * part));
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, newline));
+            mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(hit) << (16 * part);
+        }
+        if (!visitBits(mask, i, visit)) return false;
+    }
+    return scanScalar(data, i, size, visit);
+}
+
+template <class Visit>
+__attribute__((target("avx2"))) static bool scanAvx2(const char *data, size_t size, Visit &visit) {
+    const __m256i comma = _mm256_set1_epi8(','), newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m256i low = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i high = _mm256_loadu_si256((const __m256i *)(data + i + 32));
+        __m256i hitLow = _mm256_or_si256(_mm256_cmpeq_epi8(low, comma), _mm256_cmpeq_epi8(low, newline));
+        __m256i hitHigh = _mm256_or_si256(_mm256_cmpeq_epi8(high, comma), _mm256_cmpeq_epi8(high, newline));
+        uint64_t mask = (uint64_t)(uint32_t)_mm256_movemask_epi8(hitLow) |
+                        ((uint64_t)(uint32_t)_mm256_movemask_epi8(hitHigh) << 32);
+        if (!visitBits(mask, i, visit)) return false;
+    }
+    return scanScalar(data, i, size, visit);
+}
+
+#endif
+
+template <class Visit>
+static bool scan(const char *data, size_t size, SimdLevel level, Visit &visit) {
+#ifdef SUBWAY_HAVE_X86_SIMD
+    if (level == SIMD_AVX2) return scanAvx2(data, size, visit);
+    if (level == SIMD_SSE2) return scanSse2(data, size, visit);
+#endif
+    (void)level;
+    return scanScalar(data, 0, size, visit);
+}
+
+void findSeparators(const char *data, size_t size, SimdLevel level, std::vector<uint32_t> &out) {
+    auto append = [&out](uint32_t at) {
+        out.push_back(at);
+        return true;
+    };
+    scan(data, size, level, append);
+}
+
+std::vector<QueryBlock> splitQueryBlocks(const char *data, size_t size, size_t blockBytes) {
+    std::vector<QueryBlock> blocks;
+    size_t begin = 0;
+    while (begin < size) {
+        size_t end = std::min(size, begin + std::max<size_t>(1, blockBytes));
+        if (end < size) {
+            const void *newline = std::memchr(data + end - 1, '\n', size - (end - 1));
+            end = newline ? (size_t)((const char *)newline - data) + 1 : size;
+        }
+        blocks.push_back({begin, end});
+        begin = end;
+    }
+    return blocks;
+}
+
+static std::string_view trim(std::string_view field) {
+    while (!field.empty() && (field.back() == ' ' || field.back() == '\r')) field.remove_suffix(1);
+    while (!field.empty() && field.front() == ' ') field.remove_prefix(1);
+    return field;
+}
+
+// Resolves a station field: an all-digit field is a station ID, anything else a
+// registered name.
+static int stationOf(std::string_view field, const NameIndex &stations) {
+    field = trim(field);
+    if (field.empty()) return -1;
+    uint64_t value = 0;
+    size_t i = 0;
+    for (; i < field.size() && i < 10 && (unsigned)(field[i] - '0') < 10; i++) value = value * 10 + (field[i] - '0');
+    if (i == field.size()) return value < stations.size() ? (int)value : -1;
+    return stations.find(field);
+}
+
+// Parses a trip count. Plain "123" and "12.5" are read directly; other forms
+// (exponents, long fractions) go through from_chars.
+static bool parseTrips(std::string_view cell, double &trips) {
+    cell = trim(cell);
+    uint64_t whole = 0, fraction = 0, scale = 1;
+    size_t i = 0;
+    for (; i < cell.size() && i < 15 && (unsigned)(cell[i] - '0') < 10; i++) whole = whole * 10 + (cell[i] - '0');
+    if (i > 0 && i < cell.size() && cell[i] == '.') {
+        size_t digits = 0;
+        for (i++; i < cell.size() && digits < 6 && (unsigned)(cell[i] - '0') < 10; i++, digits++) {
+            fraction = fraction * 10 + (cell[i] - '0');
+            scale *= 10;
+        }
+    }
+    if (i > 0 && i == cell.size()) {
+        trips = (double)whole + (double)fraction / (double)scale;
+        return true;
+    }
+    auto result = std::from_chars(cell.data(), cell.data() + cell.size(), trips);
+    return result.ec == std::errc() && result.ptr == cell.data() + cell.size();
+}
+
+bool parseQueryBlock(const char *data, size_t size, const NameIndex &stations, SimdLevel level,
+                     std::vector<OdDemand> &out, std::string &error) {
+    // Separator offsets are 32-bit; larger inputs must be split into blocks first.
+    if (size > UINT32_MAX) {
+        error = "block larger than 4 GiB";
+        return false;
+    }
+    out.clear();
+    out.reserve(size / 16);
+
+    // Fields of the current line are handled as the scanner reaches each separator.
+    std::string_view fields[3];
+    int fieldCount = 0;
+    uint32_t lineStart = 0, fieldStart = 0;
+    auto visit = [&](uint32_t at) {
+        if (fieldCount < 3) fields[fieldCount] = std::string_view(data + fieldStart, at - fieldStart);
+        fieldCount++;
+        fieldStart = at + 1;
+        if (at < size && data[at] != '\n') return true;
+
+        int count = fieldCount;
+        uint32_t start = lineStart;
+        fieldCount = 0;
+        lineStart = at + 1;
+        if (count == 1 && trim(fields[0]).empty()) return true;
+        if (trim(fields[0]) == "origin" && stations.find("origin") < 0) return true;
+        int origin = count >= 2 && count <= 3 ? stationOf(fields[0], stations) : -1;
+        int destination = origin >= 0 ? stationOf(fields[1], stations) : -1;
+        double trips = 1.0;
+        if (count == 3 && !parseTrips(fields[2], trips)) destination = -1;
+        if (destination < 0) {
+            error = "malformed query line '" + std::string(data + start, std::min<size_t>(at - start, 80)) + "'";
+            return false;
+        }
+        if (trips > 0 && origin != destination) out.push_back({origin, destination, trips});
+        return true;
+    };
+    // The last line may lack a newline; the end of the block closes it.
+    return scan(data, size, level, visit) && visit((uint32_t)size);
+}
+
+} // namespace subway
@@ -0,0 +1,133 @@
+#include "subway/replay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+#include "subway/search_tree.h"
+
+namespace subway {
+
+bool loadEventFeed(const std::string &path, std::vector<FeedEvent> &events, std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    uint32_t count = 0;
+    if (!in.read(magic, 4) || std::memcmp(magic, "EVT1", 4) != 0 || !in.read((char *)&count, sizeof(count))) {
+        error = "not an EVT1 feed: " + path;
+        return false;
+    }
+    // Check the count against the bytes left before allocating for it.
+    std::streamoff header = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streamoff remaining = in.tellg() - header;
+    in.seekg(header);
+    if ((uint64_t)count * sizeof(FeedEvent) > (uint64_t)remaining) {
+        error = "truncated feed: " + std::to_string(count) + " events declared, room for " +
+                std::to_string(remaining / (std::streamoff)sizeof(FeedEvent));
+        return false;
+    }
+    events.resize(count);
+    if (!in.read((char *)events.data(), (std::streamsize)count * sizeof(FeedEvent))) {
+        error = "truncated feed";
+        return false;
+    }
+    if (!std::is_sorted(events.begin(), events.end(),
+                        [](const FeedEvent &a, const FeedEvent &b) { return a.timestamp < b.timestamp; })) {
+        error = "events are not sorted by timestamp";
+        return false;
+    }
+    return true;
+}
+
+std::vector<SliceStats> replayFeed(const GraphView &view, const std::vector<FeedEvent> &events, uint32_t sliceSeconds,
+                                   const std::vector<OdDemand> &queries, int transferCost, int threads) {
+    const size_t m = view.edges.size();
+    std::unordered_map<uint32_t, int> position; // global edge ID -> position in view.edges
+    for (size_t e = 0; e < m; e++) position[view.edges[e].edgeId] = (int)e;
+    std::vector<int> costs(m), delay(m, 0);
+    std::vector<char> closed(m, 0);
+    for (size_t e = 0; e < m; e++) costs[e] = view.edges[e].cost;
+
+    std::vector<int> origins;
+    for (const auto &q : queries) origins.push_back(q.origin);
+    std::sort(origins.begin(), origins.end());
+    origins.erase(std::unique(origins.begin(), origins.end()), origins.end());
+    std::vector<int> treeOf(view.offsets.size() - 1, -1);
+    std::vector<SearchTree> trees(origins.size());
+    for (size_t i = 0; i < origins.size(); i++) {
+        treeOf[origins[i]] = (int)i;
+        buildSearchTree(view, origins[i], transferCost, trees[i], &costs);
+    }
+
+    threads = std::max(1, threads);
+    std::vector<SliceStats> stats;
+    std::vector<char> touched(m, 0);
+    volatile long long sink = 0; // keeps the query loop from being optimized away
+    for (size_t i = 0; i < events.size();) {
+        uint32_t start = events[i].timestamp - events[i].timestamp % sliceSeconds;
+        SliceStats slice{start, 0, 0, 0, 0};
+        auto t0 = std::chrono::steady_clock::now();
+
+        // Fold the batch into per-edge state; each edge is repaired once.
+        std::vector<int> changed;
+        for (; i < events.size() && events[i].timestamp < start + sliceSeconds; i++) {
+            slice.events++;
+            auto it = position.find(events[i].edgeId);
+            if (it == position.end()) continue; // edge not in this view
+            int e = it->second;
+            if (events[i].kind == FEED_DELAY) delay[e] = events[i].value;
+            else closed[e] = events[i].kind == FEED_CLOSE;
+            if (!touched[e]) {
+                touched[e] = 1;
+                changed.push_back(e);
+            }
+        }
+        std::vector<int> oldCosts;
+        for (int e : changed) {
+            touched[e] = 0;
+            oldCosts.push_back(costs[e]);
+        }
+        slice.changedEdges = changed.size();
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            // Replays the batch edge by edge; each step changes exactly one edge.
+            std::vector<int> local = costs;
+            for (size_t t = next++; t < trees.size(); t = next++) {
+                for (size_t c = 0; c < changed.size(); c++) local[changed[c]] = oldCosts[c];
+                for (int e : changed) {
+                    local[e] = closed[e] ? -1 : std::max(0, view.edges[e].cost + delay[e]);
+                    repairSearchTree(view, transferCost, local, e, trees[t]);
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+        worker();
+        for (auto &t : pool) t.join();
+        for (int e : changed) costs[e] = closed[e] ? -1 : std::max(0, view.edges[e].cost + delay[e]);
+        auto t1 = std::chrono::steady_clock::now();
+
+        // Answer the workload: cost plus the walk along the tree path.
+        for (const auto &q : queries) {
+            const SearchTree &tree = trees[treeOf[q.origin]];
+            long long hops = 0;
+            if (tree.dist[q.destination] != std::numeric_limits<int>::max()) {
+                for (int cur = q.destination; cur != q.origin; cur = tree.parentStation[cur]) hops++;
+            }
+            sink += tree.dist[q.destination] + hops;
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        slice.updateMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        slice.queryMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        stats.push_back(slice);
+    }
+    return stats;
+}
+
+} // namespace subway
@@ -0,0 +1,236 @@
+#include "subway/results.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace subway {
+
+void ResultBlock::add(int from, int to, const Route &route) {
+    origin.push_back((uint32_t)from);
+    destination.push_back((uint32_t)to);
+    cost.push_back(route.cost);
+    for (const RouteLeg &leg : route.legs) {
+        legBoard.push_back((uint32_t)leg.board);
+        legAlight.push_back((uint32_t)leg.alight);
+        legLine.push_back((uint32_t)leg.lineId);
+        legStops.push_back((uint32_t)leg.stops);
+        legCost.push_back(leg.cost);
+    }
+    legOffsets.push_back((uint32_t)legBoard.size());
+}
+
+void ResultBlock::clear() {
+    origin.clear();
+    destination.clear();
+    cost.clear();
+    legOffsets.assign(1, 0);
+    legBoard.clear();
+    legAlight.clear();
+    legLine.clear();
+    legStops.clear();
+    legCost.clear();
+}
+
+// Column coding: each value is stored as the zigzag varint of its difference
+// from the previous value of the column. Sorted or repetitive columns (origins,
+// offsets, lines) mostly take one byte per value.
+template <class T>
+static void putColumn(const std::vector<T> &column, std::vector<uint8_t> &out) {
+    uint32_t previous = 0;
+    for (T value : column) {
+        uint32_t delta = (uint32_t)value - previous;
+        previous = (uint32_t)value;
+        uint32_t zigzag = (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+        while (zigzag >= 0x80) {
+            out.push_back((uint8_t)(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        out.push_back((uint8_t)zigzag);
+    }
+}
+
+template <class T>
+static bool getColumn(const uint8_t *&in, const uint8_t *end, size_t count, std::vector<T> &column) {
+    if ((size_t)(end - in) < count) return false; // every value takes at least one byte
+    column.resize(count);
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t zigzag = 0;
+        for (int shift = 0;; shift += 7) {
+            if (in == end || shift > 28) return false;
+            uint8_t byte = *in++;
+            zigzag |= (uint32_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        previous += (zigzag >> 1) ^ (0u - (zigzag & 1));
+        column[i] = (T)previous;
+    }
+    return true;
+}
+
+template <class T>
+static void putRaw(const std::vector<T> &column, std::vector<uint8_t> &out) {
+    size_t at = out.size();
+    out.resize(at + column.size() * sizeof(T));
+    if (!column.empty()) std::memcpy(out.data() + at, column.data(), column.size() * sizeof(T));
+}
+
+template <class T>
+static bool getRaw(const uint8_t *&in, const uint8_t *end, size_t count, std::vector<T> &column) {
+    if ((size_t)(end - in) < count * sizeof(T)) return false;
+    column.resize(count);
+    if (count) std::memcpy(column.data(), in, count * sizeof(T));
+    in += count * sizeof(T);
+    return true;
+}
+
+void encodeResultBlock(const ResultBlock &block, std::vector<uint8_t> &out) {
+    const uint32_t rows = (uint32_t)block.rows(), legs = (uint32_t)block.legBoard.size();
+    const size_t rawBytes = (size_t)rows * 3 * 4 + (rows + 1) * 4 + (size_t)legs * 5 * 4;
+    out.clear();
+    out.resize(16);
+    putColumn(block.origin, out);
+    putColumn(block.destination, out);
+    putColumn(block.cost, out);
+    putColumn(block.legOffsets, out);
+    putColumn(block.legBoard, out);
+    putColumn(block.legAlight, out);
+    putColumn(block.legLine, out);
+    putColumn(block.legStops, out);
+    putColumn(block.legCost, out);
+    uint32_t codec = 1;
+    if (out.size() - 16 >= rawBytes) {
+        codec = 0;
+        out.resize(16);
+        putRaw(block.origin, out);
+        putRaw(block.destination, out);
+        putRaw(block.cost, out);
+        putRaw(block.legOffsets, out);
+        putRaw(block.legBoard, out);
+        putRaw(block.legAlight, out);
+        putRaw(block.legLine, out);
+        putRaw(block.legStops, out);
+        putRaw(block.legCost, out);
+    }
+    const uint32_t header[4] = {rows, legs, codec, (uint32_t)(out.size() - 16)};
+    std::memcpy(out.data(), header, sizeof(header));
+}
+
+ResultWriter::ResultWriter(size_t queueCapacity) : queue(queueCapacity) {}
+
+ResultWriter::~ResultWriter() {
+    std::string error;
+    close(error);
+}
+
+bool ResultWriter::open(const std::string &path, std::string &error) {
+    if (!out.open(path, error) || !out.write("RES1", 4, error)) return false;
+    closing = false;
+    ioError.clear();
+    ioThread = std::thread(&ResultWriter::ioLoop, this);
+    return true;
+}
+
+void ResultWriter::submit(const ResultBlock &block) {
+    std::vector<uint8_t> bytes;
+    encodeResultBlock(block, bytes);
+    while (!queue.tryPush(std::move(bytes))) std::this_thread::yield();
+}
+
+void ResultWriter::ioLoop() {
+    std::vector<uint8_t> bytes;
+    for (;;) {
+        if (!queue.tryPop(bytes)) {
+            // Producers are done once 'closing' is set, so an empty queue then is final.
+            if (closing.load(std::memory_order_acquire)) {
+                if (!queue.tryPop(bytes)) break;
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                continue;
+            }
+        }
+        // After a failure the queue is still drained so producers never block.
+        if (ioError.empty()) out.write(bytes.data(), bytes.size(), ioError);
+    }
+}
+
+bool ResultWriter::close(std::string &error) {
+    if (!out.isOpen()) return true;
+    closing.store(true, std::memory_order_release);
+    if (ioThread.joinable()) ioThread.join();
+    std::string closeError;
+    bool ok = out.close(closeError) && ioError.empty();
+    if (!ok) error = ioError.empty() ? closeError : ioError;
+    return ok;
+}
+
+ResultReader::~ResultReader() {
+    close();
+}
+
+bool ResultReader::open(const std::string &path, std::string &error) {
+    close();
+    file = std::fopen(path.c_str(), "rb");
+    char magic[4] = {};
+    if (!file || std::fread(magic, 1, 4, file) != 4 || std::memcmp(magic, "RES1", 4) != 0) {
+        error = "not a RES1 result file: " + path;
+        close();
+        return false;
+    }
+    fseeko(file, 0, SEEK_END);
+    fileSize = (uint64_t)ftello(file);
+    fseeko(file, 4, SEEK_SET);
+    return true;
+}
+
+bool ResultReader::next(ResultBlock &block, std::string &error) {
+    error.clear();
+    if (!file) return false;
+    uint32_t header[4];
+    size_t got = std::fread(header, 1, sizeof(header), file);
+    if (got == 0) return false;
+    const uint32_t rows = header[0], legs = header[1], codec = header[2];
+    if (got != sizeof(header)) {
+        error = "truncated block header";
+        return false;
+    }
+    // Bound the declared length by what is left of the file before allocating it.
+    uint64_t left = fileSize - (uint64_t)ftello(file);
+    if (header[3] > left) {
+        error = "corrupt block: " + std::to_string(header[3]) + " payload bytes declared, " +
+                std::to_string(left) + " left in file";
+        return false;
+    }
+    payload.resize(header[3]);
+    if (codec > 1 || std::fread(payload.data(), 1, payload.size(), file) != payload.size()) {
+        error = "truncated or corrupt block";
+        return false;
+    }
+    const uint8_t *in = payload.data(), *end = in + payload.size();
+    bool ok;
+    if (codec == 1) {
+        ok = getColumn(in, end, rows, block.origin) && getColumn(in, end, rows, block.destination) &&
+             getColumn(in, end, rows, block.cost) && getColumn(in, end, rows + 1, block.legOffsets) &&
+             getColumn(in, end, legs, block.legBoard) && getColumn(in, end, legs, block.legAlight) &&
+             getColumn(in, end, legs, block.legLine) && getColumn(in, end, legs, block.legStops) &&
+             getColumn(in, end, legs, block.legCost);
+    } else {
+        ok = getRaw(in, end, rows, block.origin) && getRaw(in, end, rows, block.destination) &&
+             getRaw(in, end, rows, block.cost) && getRaw(in, end, rows + 1, block.legOffsets) &&
+             getRaw(in, end, legs, block.legBoard) && getRaw(in, end, legs, block.legAlight) &&
+             getRaw(in, end, legs, block.legLine) && getRaw(in, end, legs, block.legStops) &&
+             getRaw(in, end, legs, block.legCost);
+    }
+    if (!ok || in != end || block.legOffsets.back() != legs) {
+        error = "corrupt block";
+        return false;
+    }
+    return true;
+}
+
+void ResultReader::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+}
+
+} // namespace subway
@@ -0,0 +1,57 @@
+#include "subway/sample.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace subway {
+
+void buildSampleGraph(Graph &graph) {
+    for (const auto &seg : kSampleSegments) {
+        graph.addBidirectionalEdge(std::string(seg.from), std::string(seg.to), seg.cost, std::string(seg.line));
+    }
+
+    // Accessibility: Houston St has no elevator, and the Grand Central <-> Union Sq
+    // passageway has stairs.
+    graph.setStationAttributes("Houston St", ATTR_INACCESSIBLE);
+    graph.setSegmentAttributes("Grand Central", "Union Sq", "Interchange", ATTR_INACCESSIBLE);
+    graph.finalize();
+}
+
+FareModel buildSampleFares(const Graph &graph) {
+    FareModel fares = graph.makeFareModel(290, 120);
+    fares.surcharge[graph.findLine("3")] = 100;
+    return fares;
+}
+
+FrequencyModel buildSampleFrequencies(const Graph &graph) {
+    FrequencyModel frequencies = graph.makeFrequencyModel(8);
+    // 00:00 night, 06:00 early, 07:00 peak, 10:00 midday, 16:00 peak, 19:00 evening.
+    for (const char *line : {"1", "2"})
+        frequencies.setBands(graph.findLine(line), {{0, 20}, {360, 8}, {420, 4}, {600, 6}, {960, 4}, {1140, 8}});
+    frequencies.setBands(graph.findLine("3"), {{0, 30}, {360, 12}, {420, 6}, {600, 10}, {960, 6}, {1140, 12}});
+    return frequencies;
+}
+
+ShapeStore buildSampleShapes(const Graph &graph) {
+    std::vector<ShapePoint> coords(graph.stationNames.size(), ShapePoint{0, 0});
+    for (size_t s = 0; s < kSampleStations.size(); s++) {
+        int id = graph.findStation(kSampleStations[s]);
+        if (id >= 0) coords[id] = kSampleStationCoords[s];
+    }
+    return buildStationShapes(graph, coords);
+}
+
+void generateCityNetwork(Graph &graph, int rows, int cols, unsigned seed) {
+    std::mt19937 rng(seed);
+    auto name = [](int r, int c) { return "S" + std::to_string(r) + "_" + std::to_string(c); };
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c + 1 < cols; c++)
+            graph.addBidirectionalEdge(name(r, c), name(r, c + 1), 1 + (int)(rng() % 9), "R" + std::to_string(r));
+    for (int c = 0; c < cols; c++)
+        for (int r = 0; r + 1 < rows; r++)
+            graph.addBidirectionalEdge(name(r, c), name(r + 1, c), 1 + (int)(rng() % 9), "C" + std::to_string(c));
+    graph.finalize();
+}
+
+} // namespace subway
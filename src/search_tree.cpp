@@ -0,0 +1,151 @@
+#include "subway/search_tree.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "subway/cost.h"
+
+namespace subway {
+
+int edgeSource(const GraphView &view, int e) {
+    return (int)(std::upper_bound(view.offsets.begin(), view.offsets.end(), e) - view.offsets.begin()) - 1;
+}
+
+namespace {
+
+typedef std::pair<int, int> QueueEntry; // {cost, station}
+typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> TreeQueue;
+
+// Relaxes the edges of 'station', settled at its tree distance.
+void relaxEdges(const GraphView &view, int transferCost, const std::vector<int> *edgeCosts, int station,
+                SearchTree &tree, TreeQueue &pq) {
+    const int cost = tree.dist[station];
+    for (int e = view.offsets[station]; e < view.offsets[station + 1]; e++) {
+        const ViewEdge &edge = view.edges[e];
+        int edgeCost = edgeCosts ? (*edgeCosts)[e] : edge.cost;
+        if (edgeCost < 0)
+            continue;
+        int extra = 0;
+        if (tree.arrivalLine[station] != -1 && tree.arrivalLine[station] != edge.lineId)
+            extra = transferCost;
+        int newCost = CostTraits<int>::add(cost, edgeCost + extra);
+        if (newCost < tree.dist[edge.destination]) {
+            tree.dist[edge.destination] = newCost;
+            tree.parentEdge[edge.destination] = e;
+            tree.parentStation[edge.destination] = station;
+            tree.arrivalLine[edge.destination] = edge.lineId;
+            pq.push({newCost, edge.destination});
+        }
+    }
+}
+
+// Settles stations in (cost, station) order until the queue is empty, appending
+// them to the settle order.
+void settleAll(const GraphView &view, int transferCost, const std::vector<int> *edgeCosts, SearchTree &tree,
+               TreeQueue &pq) {
+    while (!pq.empty()) {
+        auto [cost, station] = pq.top();
+        pq.pop();
+        if (cost > tree.dist[station])
+            continue;
+        tree.settleOrder.push_back(station);
+        relaxEdges(view, transferCost, edgeCosts, station, tree, pq);
+    }
+}
+
+} // namespace
+
+void buildSearchTree(const GraphView &view, int source, int transferCost, SearchTree &tree,
+                     const std::vector<int> *edgeCosts) {
+    const int n = (int)view.offsets.size() - 1;
+    tree.dist.assign(n, std::numeric_limits<int>::max());
+    tree.parentEdge.assign(n, -1);
+    tree.parentStation.assign(n, -1);
+    tree.arrivalLine.assign(n, -1);
+    tree.settleOrder.clear();
+    tree.source = source;
+    tree.dist[source] = 0;
+
+    TreeQueue pq;
+    pq.push({0, source});
+    settleAll(view, transferCost, edgeCosts, tree, pq);
+}
+
+int repairSearchTree(const GraphView &view, int transferCost, const std::vector<int> &costs, int changed,
+                     SearchTree &tree) {
+    const int INF = std::numeric_limits<int>::max();
+    const int n = (int)view.offsets.size() - 1;
+    const int u = edgeSource(view, changed), v = view.edges[changed].destination;
+    auto costVia = [&](int p, int from) {
+        if (costs[p] < 0 || tree.dist[from] == INF) return INF;
+        int extra = 0;
+        if (tree.arrivalLine[from] != -1 && tree.arrivalLine[from] != view.edges[p].lineId)
+            extra = transferCost;
+        return CostTraits<int>::add(tree.dist[from], costs[p] + extra);
+    };
+
+    // The edge is only relaxed when u is settled. If u is never settled, or the
+    // edge neither carries v's label nor reaches v at or below its cost, no
+    // relaxation of the search turns out differently.
+    if (tree.dist[u] == INF || v == tree.source) return 0;
+    if (tree.parentEdge[v] != changed && costVia(changed, u) > tree.dist[v]) return 0;
+
+    // Stations settled before u keep their labels; every other station is reopened.
+    // Zero-cost edges can settle a station after another of the same cost and a
+    // higher ID, so the order is the one the search recorded.
+    std::vector<int> rank(n, n);
+    for (size_t i = 0; i < tree.settleOrder.size(); i++) rank[tree.settleOrder[i]] = (int)i;
+    std::vector<char> open(n, 0);
+    std::vector<int> reopened;
+    for (int x = 0; x < n; x++) {
+        if (rank[x] > rank[u]) {
+            open[x] = 1;
+            reopened.push_back(x);
+        }
+    }
+    tree.settleOrder.resize(rank[u] + 1);
+    std::vector<int> oldDist, oldParent;
+    for (int x : reopened) {
+        oldDist.push_back(tree.dist[x]);
+        oldParent.push_back(tree.parentEdge[x]);
+    }
+    // A reopened station holds the label the search had given it when u was
+    // reached: the cheapest relaxation from a settled station, the earliest settled
+    // (then lowest edge position) on ties, as strict improvements keep the first.
+    TreeQueue pq;
+    for (int x : reopened) {
+        int best = INF, bestEdge = -1, bestFrom = -1;
+        for (int r = view.reverseOffsets[x]; r < view.reverseOffsets[x + 1]; r++) {
+            int p = view.reverseEdges[r];
+            int y = edgeSource(view, p);
+            if (open[y] || y == u) continue;
+            int via = costVia(p, y);
+            if (via == INF) continue;
+            bool earlier = bestEdge == -1 || rank[y] < rank[bestFrom] || (y == bestFrom && p < bestEdge);
+            if (via < best || (via == best && earlier)) {
+                best = via;
+                bestEdge = p;
+                bestFrom = y;
+            }
+        }
+        tree.dist[x] = best;
+        tree.parentEdge[x] = bestEdge;
+        tree.parentStation[x] = bestFrom;
+        tree.arrivalLine[x] = bestEdge == -1 ? -1 : view.edges[bestEdge].lineId;
+        if (best != INF) pq.push({best, x});
+    }
+    // Resume the search at u with the new costs.
+    relaxEdges(view, transferCost, &costs, u, tree, pq);
+    settleAll(view, transferCost, &costs, tree, pq);
+
+    int updated = 0;
+    for (size_t i = 0; i < reopened.size(); i++)
+        updated += tree.dist[reopened[i]] != oldDist[i] || tree.parentEdge[reopened[i]] != oldParent[i];
+    return updated;
+}
+
+} // namespace subway
@@ -0,0 +1,202 @@
+#include "subway/timetable.h"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+namespace subway {
+
+size_t Timetable::memoryBytes() const {
+    return (routeLine.size() + routeStopOffsets.size() + routeStops.size() + routeTripOffsets.size() +
+            tripRoute.size() + tripEventOffsets.size() + arrival.size() + departure.size() +
+            stationStopOffsets.size() + footpathOffsets.size()) * sizeof(int) +
+           stationStops.size() * sizeof(std::pair<int, int>) + footpaths.size() * sizeof(Footpath);
+}
+
+int Timetable::earliestTrip(int route, int stop, int time) const {
+    int lo = routeTripOffsets[route], hi = routeTripOffsets[route + 1];
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (departure[tripEventOffsets[mid] + stop] < time) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < routeTripOffsets[route + 1] ? lo : -1;
+}
+
+Timetable buildTimetable(const Graph &graph, const GraphView &view, int headway, int serviceStart, int serviceEnd,
+                         int transferTime) {
+    Timetable tt;
+    tt.transferTime = transferTime;
+    const int n = (int)view.offsets.size() - 1;
+    const int lines = (int)graph.lineNames.size();
+    const int walking = graph.findLine("Interchange");
+    headway = std::max(1, headway);
+
+    // Undirected neighbours of each station on each line, and the directed edge costs.
+    std::vector<std::vector<std::vector<int>>> neighbours(lines, std::vector<std::vector<int>>(n));
+    std::vector<std::vector<Footpath>> walks(n);
+    auto edgeCost = [&](int from, int to, int line) {
+        for (int e = view.offsets[from]; e < view.offsets[from + 1]; e++)
+            if (view.edges[e].destination == to && view.edges[e].lineId == line) return view.edges[e].cost;
+        return -1;
+    };
+    for (int s = 0; s < n; s++) {
+        for (int e = view.offsets[s]; e < view.offsets[s + 1]; e++) {
+            const ViewEdge &edge = view.edges[e];
+            if (edge.lineId == walking) {
+                walks[s].push_back({edge.destination, edge.cost});
+                continue;
+            }
+            auto &from = neighbours[edge.lineId][s], &to = neighbours[edge.lineId][edge.destination];
+            if (std::find(from.begin(), from.end(), edge.destination) == from.end()) from.push_back(edge.destination);
+            if (std::find(to.begin(), to.end(), s) == to.end()) to.push_back(s);
+        }
+    }
+
+    tt.routeStopOffsets.push_back(0);
+    tt.routeTripOffsets.push_back(0);
+    tt.tripEventOffsets.push_back(0);
+    auto addRoute = [&](int line, const std::vector<int> &stops) {
+        std::vector<int> running;
+        for (size_t i = 0; i + 1 < stops.size(); i++) {
+            int cost = edgeCost(stops[i], stops[i + 1], line);
+            if (cost < 0) return;
+            running.push_back(cost);
+        }
+        const int route = (int)tt.routeLine.size();
+        tt.routeLine.push_back(line);
+        tt.routeStops.insert(tt.routeStops.end(), stops.begin(), stops.end());
+        tt.routeStopOffsets.push_back((int)tt.routeStops.size());
+        for (int start = serviceStart + (line * 7 + (int)stops.size()) % headway; start <= serviceEnd; start += headway) {
+            tt.tripRoute.push_back(route);
+            int time = start;
+            for (size_t i = 0; i < stops.size(); i++) {
+                if (i > 0) time += running[i - 1];
+                tt.arrival.push_back(time);
+                tt.departure.push_back(time);
+            }
+            tt.tripEventOffsets.push_back((int)tt.arrival.size());
+        }
+        tt.routeTripOffsets.push_back((int)tt.tripRoute.size());
+    };
+
+    // Runs start at stations where the line does not simply pass through; what is
+    // left afterwards are loops, which are opened at their lowest station.
+    for (int line = 0; line < lines; line++) {
+        if (line == walking) continue;
+        std::set<std::pair<int, int>> used;
+        auto walkRun = [&](int start, int next) {
+            std::vector<int> stops = {start};
+            int prev = start, cur = next;
+            used.insert({std::min(prev, cur), std::max(prev, cur)});
+            stops.push_back(cur);
+            while (neighbours[line][cur].size() == 2 && cur != start) {
+                int after = neighbours[line][cur][0] == prev ? neighbours[line][cur][1] : neighbours[line][cur][0];
+                if (!used.insert({std::min(cur, after), std::max(cur, after)}).second) break;
+                prev = cur;
+                cur = after;
+                stops.push_back(cur);
+            }
+            addRoute(line, stops);
+            std::reverse(stops.begin(), stops.end());
+            addRoute(line, stops);
+        };
+        for (int pass = 0; pass < 2; pass++) {
+            for (int s = 0; s < n; s++) {
+                if (pass == 0 && neighbours[line][s].size() == 2) continue;
+                for (int next : neighbours[line][s]) {
+                    if (!used.count({std::min(s, next), std::max(s, next)})) walkRun(s, next);
+                }
+            }
+        }
+    }
+
+    std::vector<std::vector<std::pair<int, int>>> stops(n);
+    for (int r = 0; r < tt.routeCount(); r++) {
+        for (int i = 0; i < tt.stopCount(r); i++) stops[tt.routeStops[tt.routeStopOffsets[r] + i]].push_back({r, i});
+    }
+    tt.stationStopOffsets.push_back(0);
+    tt.footpathOffsets.push_back(0);
+    for (int s = 0; s < n; s++) {
+        tt.stationStops.insert(tt.stationStops.end(), stops[s].begin(), stops[s].end());
+        tt.stationStopOffsets.push_back((int)tt.stationStops.size());
+        tt.footpaths.insert(tt.footpaths.end(), walks[s].begin(), walks[s].end());
+        tt.footpathOffsets.push_back((int)tt.footpaths.size());
+    }
+    return tt;
+}
+
+int raptorArrival(const Timetable &tt, int source, int target, int departure, int maxTrips) {
+    const int INF = std::numeric_limits<int>::max();
+    const int n = (int)tt.stationStopOffsets.size() - 1;
+    // best: earliest arrival; ready: earliest time a vehicle can be boarded there.
+    std::vector<int> best(n, INF), ready(n, INF), previous;
+    std::vector<char> marked(n, 0);
+    best[source] = ready[source] = departure;
+    marked[source] = 1;
+    for (int f = tt.footpathOffsets[source]; f < tt.footpathOffsets[source + 1]; f++) {
+        const Footpath &walk = tt.footpaths[f];
+        best[walk.to] = std::min(best[walk.to], departure + walk.time);
+        ready[walk.to] = std::min(ready[walk.to], departure + walk.time);
+        marked[walk.to] = 1;
+    }
+
+    std::vector<int> firstStop(tt.routeCount());
+    std::vector<int> routes, reached;
+    for (int round = 0; round < maxTrips; round++) {
+        previous = ready;
+        // Routes serving marked stations, from the earliest marked stop.
+        routes.clear();
+        for (int s = 0; s < n; s++) {
+            if (!marked[s]) continue;
+            marked[s] = 0;
+            for (int x = tt.stationStopOffsets[s]; x < tt.stationStopOffsets[s + 1]; x++) {
+                auto [route, stop] = tt.stationStops[x];
+                if (std::find(routes.begin(), routes.end(), route) == routes.end()) {
+                    routes.push_back(route);
+                    firstStop[route] = stop;
+                } else {
+                    firstStop[route] = std::min(firstStop[route], stop);
+                }
+            }
+        }
+        if (routes.empty()) break;
+        reached.clear();
+        for (int route : routes) {
+            int trip = -1;
+            const int *stops = &tt.routeStops[tt.routeStopOffsets[route]];
+            for (int i = firstStop[route]; i < tt.stopCount(route); i++) {
+                int s = stops[i];
+                if (trip != -1) {
+                    int arrival = tt.arrival[tt.event(trip, i)];
+                    if (arrival < best[s] && arrival < best[target]) {
+                        best[s] = arrival;
+                        reached.push_back(s);
+                    }
+                }
+                if (previous[s] != INF && (trip == -1 || previous[s] <= tt.departure[tt.event(trip, i)])) {
+                    int earlier = tt.earliestTrip(route, i, previous[s]);
+                    if (earlier != -1 && (trip == -1 || earlier < trip)) trip = earlier;
+                }
+            }
+        }
+        // Change within the station, or walk one footpath.
+        for (int s : reached) {
+            if (best[s] + tt.transferTime < ready[s]) {
+                ready[s] = best[s] + tt.transferTime;
+                marked[s] = 1;
+            }
+            for (int f = tt.footpathOffsets[s]; f < tt.footpathOffsets[s + 1]; f++) {
+                const Footpath &walk = tt.footpaths[f];
+                best[walk.to] = std::min(best[walk.to], best[s] + walk.time);
+                if (best[s] + walk.time < ready[walk.to]) {
+                    ready[walk.to] = best[s] + walk.time;
+                    marked[walk.to] = 1;
+                }
+            }
+        }
+    }
+    return best[target] == INF ? -1 : best[target];
+}
+
+} // namespace subway
@@ -0,0 +1,487 @@
+#include "subway/transfer_patterns.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace subway {
+
+namespace {
+
+const int kNever = std::numeric_limits<int>::max();
+const uint32_t kProgressMagic = 0x31505453; // "STP1"
+
+// How a label was reached: from the origin, by a trip boarded at 'station' in the
+// previous round, by a footpath from 'station', from the arrival at the same station
+// (ready labels only), or copied up from a label of round 'round'.
+enum ParentKind : uint8_t { kOrigin, kTrip, kWalk, kSame, kLower };
+
+struct Parent {
+    uint8_t kind;
+    uint8_t round;
+    int station;
+};
+
+// Patterns of one origin: the prefix tree and its {target, node} ends.
+struct OriginPatterns {
+    std::vector<PatternNode> nodes;
+    std::vector<std::pair<int, int>> ends;
+};
+
+// Range RAPTOR from one origin over all its departures, latest first. Labels of
+// later departures are kept, since they remain valid when leaving earlier, so each
+// departure only propagates improvements. Round k labels are monotone in k (an
+// improvement is copied to the higher rounds); every label set by a trip or footpath
+// in the current departure is a Pareto-optimal journey, whose stations are added to
+// the prefix tree when the departure is done.
+class RangeRaptor {
+public:
+    RangeRaptor(const Timetable &timetable, int maxTrips)
+        : tt(timetable), n((int)timetable.stationStopOffsets.size() - 1), rounds(maxTrips),
+          arrival((size_t)(maxTrips + 1) * n), ready((size_t)(maxTrips + 1) * n),
+          arrivalParent((size_t)(maxTrips + 1) * n), readyParent((size_t)(maxTrips + 1) * n),
+          improvedStamp((size_t)(maxTrips + 1) * n, 0), marked(n, 0), firstStop(timetable.routeCount(), -1) {}
+
+    void run(int origin, int from, int to, OriginPatterns &out);
+
+private:
+    const Timetable &tt;
+    const int n;
+    const int rounds;
+    std::vector<int> arrival, ready; // by round * stations + station
+    std::vector<Parent> arrivalParent, readyParent;
+    std::vector<uint32_t> improvedStamp;
+    uint32_t stamp = 0;
+    std::vector<int> improved;
+    std::vector<char> marked;
+    std::vector<int> markedStations;
+    std::vector<int> firstStop; // by route, -1 when not collected
+    std::vector<int> routes;
+    std::vector<std::pair<int, int>> reached;
+    std::vector<std::pair<int, bool>> legs;
+    std::unordered_map<uint64_t, int> children;
+
+    void setArrival(int round, int station, int time, Parent parent);
+    void setReady(int round, int station, int time, Parent parent);
+    void scanRound(int round);
+    bool extract(int origin, int label);
+    void addPattern(int target, OriginPatterns &out);
+};
+
+void RangeRaptor::setArrival(int round, int station, int time, Parent parent) {
+    size_t label = (size_t)round * n + station;
+    if (time >= arrival[label]) return;
+    arrival[label] = time;
+    arrivalParent[label] = parent;
+    if (improvedStamp[label] != stamp) {
+        improvedStamp[label] = stamp;
+        improved.push_back((int)label);
+    }
+    for (int r = round + 1; r <= rounds && time < arrival[(size_t)r * n + station]; r++) {
+        arrival[(size_t)r * n + station] = time;
+        arrivalParent[(size_t)r * n + station] = {kLower, (uint8_t)round, station};
+    }
+}
+
+void RangeRaptor::setReady(int round, int station, int time, Parent parent) {
+    size_t label = (size_t)round * n + station;
+    if (time >= ready[label]) return;
+    ready[label] = time;
+    readyParent[label] = parent;
+    for (int r = round + 1; r <= rounds && time < ready[(size_t)r * n + station]; r++) {
+        ready[(size_t)r * n + station] = time;
+        readyParent[(size_t)r * n + station] = {kLower, (uint8_t)round, station};
+    }
+    if (!marked[station]) {
+        marked[station] = 1;
+        markedStations.push_back(station);
+    }
+}
+
+void RangeRaptor::scanRound(int round) {
+    // Routes serving stations whose ready time improved, from the earliest such stop.
+    routes.clear();
+    for (int s : markedStations) {
+        marked[s] = 0;
+        for (int x = tt.stationStopOffsets[s]; x < tt.stationStopOffsets[s + 1]; x++) {
+            auto [route, stop] = tt.stationStops[x];
+            if (firstStop[route] == -1) routes.push_back(route);
+            if (firstStop[route] == -1 || stop < firstStop[route]) firstStop[route] = stop;
+        }
+    }
+    markedStations.clear();
+
+    const int *previous = &ready[(size_t)(round - 1) * n];
+    const int *current = &arrival[(size_t)round * n];
+    reached.clear();
+    for (int route : routes) {
+        int trip = -1, board = -1;
+        const int *stops = &tt.routeStops[tt.routeStopOffsets[route]];
+        for (int i = firstStop[route]; i < tt.stopCount(route); i++) {
+            int s = stops[i];
+            if (trip != -1) {
+                int time = tt.arrival[tt.event(trip, i)];
+                if (time < current[s]) {
+                    setArrival(round, s, time, {kTrip, (uint8_t)round, board});
+                    reached.push_back({s, time});
+                }
+            }
+            if (previous[s] != kNever && (trip == -1 || previous[s] <= tt.departure[tt.event(trip, i)])) {
+                int earlier = tt.earliestTrip(route, i, previous[s]);
+                if (earlier != -1 && (trip == -1 || earlier < trip)) {
+                    trip = earlier;
+                    board = s;
+                }
+            }
+        }
+        firstStop[route] = -1;
+    }
+    // Change within the station, or walk one footpath from the trip arrival.
+    for (auto [s, time] : reached) {
+        if (time == current[s]) setReady(round, s, time + tt.transferTime, {kSame, (uint8_t)round, s});
+    }
+    for (auto [s, time] : reached) {
+        if (time != current[s]) continue;
+        for (int f = tt.footpathOffsets[s]; f < tt.footpathOffsets[s + 1]; f++) {
+            const Footpath &walk = tt.footpaths[f];
+            setArrival(round, walk.to, time + walk.time, {kWalk, (uint8_t)round, s});
+            setReady(round, walk.to, time + walk.time, {kWalk, (uint8_t)round, s});
+        }
+    }
+}
+
+// Follows the parents of one label back to the origin, collecting the legs last
+// first; false if the chain does not end there.
+bool RangeRaptor::extract(int origin, int label) {
+    legs.clear();
+    int round = label / n, station = label % n;
+    bool onArrival = true;
+    for (int steps = 0; steps < 4 * (rounds + 2) + n; steps++) {
+        const Parent &parent = (onArrival ? arrivalParent : readyParent)[(size_t)round * n + station];
+        switch (parent.kind) {
+        case kOrigin:
+            return station == origin;
+        case kLower:
+            round = parent.round;
+            break;
+        case kSame:
+            onArrival = true;
+            break;
+        case kTrip:
+            legs.push_back({station, false});
+            station = parent.station;
+            round--;
+            onArrival = false;
+            break;
+        case kWalk:
+            legs.push_back({station, true});
+            station = parent.station;
+            round = parent.round;
+            onArrival = true;
+            break;
+        }
+    }
+    return false;
+}
+
+void RangeRaptor::addPattern(int target, OriginPatterns &out) {
+    int node = 0;
+    for (auto leg = legs.rbegin(); leg != legs.rend(); ++leg) {
+        uint64_t key = (uint64_t)node << 32 | (uint32_t)(leg->first * 2 + leg->second);
+        auto [it, inserted] = children.try_emplace(key, (int)out.nodes.size());
+        if (inserted) out.nodes.push_back({leg->first, node, leg->second});
+        node = it->second;
+    }
+    out.ends.push_back({target, node});
+}
+
+void RangeRaptor::run(int origin, int from, int to, OriginPatterns &out) {
+    std::fill(arrival.begin(), arrival.end(), kNever);
+    std::fill(ready.begin(), ready.end(), kNever);
+    children.clear();
+    out.nodes.assign(1, {origin, -1, false});
+    out.ends.clear();
+
+    // Departures from the origin, or from a station one footpath away.
+    std::vector<int> departures;
+    auto collect = [&](int station, int walk) {
+        for (int x = tt.stationStopOffsets[station]; x < tt.stationStopOffsets[station + 1]; x++) {
+            auto [route, stop] = tt.stationStops[x];
+            for (int trip = tt.routeTripOffsets[route]; trip < tt.routeTripOffsets[route + 1]; trip++) {
+                int time = tt.departure[tt.event(trip, stop)] - walk;
+                if (time >= from && time <= to) departures.push_back(time);
+            }
+        }
+    };
+    collect(origin, 0);
+    for (int f = tt.footpathOffsets[origin]; f < tt.footpathOffsets[origin + 1]; f++)
+        collect(tt.footpaths[f].to, tt.footpaths[f].time);
+    // The latest departure also covers walking.
+    departures.push_back(to);
+    std::sort(departures.begin(), departures.end(), std::greater<int>());
+    departures.erase(std::unique(departures.begin(), departures.end()), departures.end());
+
+    for (int departure : departures) {
+        stamp++;
+        improved.clear();
+        setArrival(0, origin, departure, {kOrigin, 0, origin});
+        setReady(0, origin, departure, {kOrigin, 0, origin});
+        for (int f = tt.footpathOffsets[origin]; f < tt.footpathOffsets[origin + 1]; f++) {
+            const Footpath &walk = tt.footpaths[f];
+            setArrival(0, walk.to, departure + walk.time, {kWalk, 0, origin});
+            setReady(0, walk.to, departure + walk.time, {kWalk, 0, origin});
+        }
+        for (int round = 1; round <= rounds && !markedStations.empty(); round++) scanRound(round);
+        for (int s : markedStations) marked[s] = 0;
+        markedStations.clear();
+
+        for (int label : improved) {
+            if (arrivalParent[label].kind == kLower || !extract(origin, label)) continue;
+            addPattern(label % n, out);
+        }
+    }
+    std::sort(out.ends.begin(), out.ends.end());
+    out.ends.erase(std::unique(out.ends.begin(), out.ends.end()), out.ends.end());
+}
+
+uint64_t fingerprint(const Timetable &tt, int from, int to, int maxTrips) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&](const void *data, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++) hash = (hash ^ ((const unsigned char *)data)[i]) * 1099511628211ull;
+    };
+    int header[] = {from, to, maxTrips, tt.transferTime};
+    mix(header, sizeof(header));
+    mix(tt.routeStopOffsets.data(), tt.routeStopOffsets.size() * sizeof(int));
+    mix(tt.routeStops.data(), tt.routeStops.size() * sizeof(int));
+    mix(tt.routeTripOffsets.data(), tt.routeTripOffsets.size() * sizeof(int));
+    mix(tt.arrival.data(), tt.arrival.size() * sizeof(int));
+    mix(tt.departure.data(), tt.departure.size() * sizeof(int));
+    mix(tt.footpaths.data(), tt.footpaths.size() * sizeof(Footpath));
+    return hash;
+}
+
+// Reads one origin record at 'pos'; false if the record is incomplete or invalid.
+bool readRecord(const std::vector<char> &data, size_t &pos, int n, int &origin, OriginPatterns &out) {
+    auto take = [&](void *value, size_t bytes) {
+        if (data.size() - pos < bytes) return false;
+        std::copy_n(&data[pos], bytes, (char *)value);
+        pos += bytes;
+        return true;
+    };
+    int32_t id;
+    uint32_t count;
+    if (!take(&id, 4) || id < 0 || id >= n || !take(&count, 4) || count == 0 || count > data.size()) return false;
+    out.nodes.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t fields[3];
+        if (!take(fields, sizeof(fields))) return false;
+        if (fields[0] < 0 || fields[0] >= n || fields[1] >= (int32_t)i || (i > 0 && fields[1] < 0)) return false;
+        out.nodes[i] = {fields[0], fields[1], fields[2] != 0};
+    }
+    if (!take(&count, 4) || count > data.size()) return false;
+    out.ends.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t fields[2];
+        if (!take(fields, sizeof(fields))) return false;
+        if (fields[0] < 0 || fields[0] >= n || fields[1] < 0 || fields[1] >= (int32_t)out.nodes.size()) return false;
+        out.ends[i] = {fields[0], fields[1]};
+    }
+    origin = id;
+    return true;
+}
+
+void writeRecord(std::ofstream &file, int origin, const OriginPatterns &patterns) {
+    std::vector<int32_t> record = {origin, (int32_t)patterns.nodes.size()};
+    for (const PatternNode &node : patterns.nodes) record.insert(record.end(), {node.station, node.parent, node.walk});
+    record.push_back((int32_t)patterns.ends.size());
+    for (auto [target, node] : patterns.ends) record.insert(record.end(), {target, node});
+    file.write((const char *)record.data(), (std::streamsize)(record.size() * sizeof(int32_t)));
+    file.flush();
+}
+
+// Loads the origins recorded in the progress file, creating it if missing. A record
+// cut short by an interruption is dropped and the file rewritten without it.
+bool loadProgress(const std::string &path, uint64_t expected, int n, std::vector<OriginPatterns> &origins,
+                  std::vector<char> &done, std::string &error) {
+    std::vector<char> data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (in) data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t headerBytes = sizeof(uint32_t) + sizeof(uint64_t);
+    size_t good = headerBytes;
+    if (data.size() >= headerBytes) {
+        uint32_t magic;
+        uint64_t hash;
+        std::copy_n(data.data(), 4, (char *)&magic);
+        std::copy_n(data.data() + 4, 8, (char *)&hash);
+        if (magic != kProgressMagic) {
+            error = "Not a transfer patterns progress file: " + path;
+            return false;
+        }
+        if (hash != expected) {
+            error = "Progress file " + path + " was written for a different timetable or window";
+            return false;
+        }
+        size_t pos = headerBytes;
+        int origin;
+        OriginPatterns record;
+        while (pos < data.size() && readRecord(data, pos, n, origin, record)) {
+            if (!done[origin]) origins[origin] = std::move(record);
+            done[origin] = 1;
+            good = pos;
+        }
+        if (good == data.size()) return true;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (data.size() >= headerBytes) {
+        out.write(data.data(), (std::streamsize)good);
+    } else {
+        out.write((const char *)&kProgressMagic, 4);
+        out.write((const char *)&expected, 8);
+    }
+    if (!out) {
+        error = "Cannot write progress file: " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+size_t TransferPatterns::memoryBytes() const {
+    return timetable.memoryBytes() + nodeOffsets.size() * sizeof(int) + nodes.size() * sizeof(PatternNode) +
+           targetOffsets.size() * sizeof(int) + targetNodes.size() * sizeof(int);
+}
+
+bool buildTransferPatterns(Timetable timetable, int from, int to, int maxTrips, int threads,
+                           const std::string &progressPath, int originBudget, TransferPatterns &patterns,
+                           std::string &error, int *resumed) {
+    const int n = (int)timetable.stationStopOffsets.size() - 1;
+    maxTrips = std::min(std::max(maxTrips, 1), 255);
+    std::vector<OriginPatterns> origins(n);
+    std::vector<char> done(n, 0);
+    if (!progressPath.empty() &&
+        !loadProgress(progressPath, fingerprint(timetable, from, to, maxTrips), n, origins, done, error))
+        return false;
+    std::vector<int> pending;
+    for (int s = 0; s < n; s++) {
+        if (!done[s]) pending.push_back(s);
+    }
+    if (resumed) *resumed = n - (int)pending.size();
+    const int budget = originBudget < 0 ? (int)pending.size() : std::min(originBudget, (int)pending.size());
+
+    std::ofstream progress;
+    if (!progressPath.empty()) progress.open(progressPath, std::ios::binary | std::ios::app);
+    std::mutex progressMutex;
+    threads = std::max(1, threads);
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        RangeRaptor search(timetable, maxTrips);
+        for (int i = next++; i < budget; i = next++) {
+            int origin = pending[i];
+            search.run(origin, from, to, origins[origin]);
+            if (progress.is_open()) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                writeRecord(progress, origin, origins[origin]);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+    if (progress.is_open() && !progress) {
+        error = "Cannot write progress file: " + progressPath;
+        return false;
+    }
+    if (budget < (int)pending.size()) {
+        error = "Computed " + std::to_string(budget) + " of " + std::to_string(pending.size()) +
+                " remaining origins; run again to resume";
+        return false;
+    }
+
+    patterns = TransferPatterns();
+    patterns.timetable = std::move(timetable);
+    patterns.maxTrips = maxTrips;
+    patterns.nodeOffsets.assign(1, 0);
+    patterns.targetOffsets.assign(1, 0);
+    for (int s = 0; s < n; s++) {
+        OriginPatterns &origin = origins[s];
+        patterns.nodes.insert(patterns.nodes.end(), origin.nodes.begin(), origin.nodes.end());
+        patterns.nodeOffsets.push_back((int)patterns.nodes.size());
+        size_t e = 0;
+        for (int t = 0; t < n; t++) {
+            for (; e < origin.ends.size() && origin.ends[e].first == t; e++)
+                patterns.targetNodes.push_back(origin.ends[e].second);
+            patterns.targetOffsets.push_back((int)patterns.targetNodes.size());
+        }
+        std::vector<PatternNode>().swap(origin.nodes);
+        std::vector<std::pair<int, int>>().swap(origin.ends);
+    }
+    return true;
+}
+
+int directConnection(const Timetable &tt, int from, int to, int time) {
+    int best = kNever;
+    for (int x = tt.stationStopOffsets[from]; x < tt.stationStopOffsets[from + 1]; x++) {
+        auto [route, boardStop] = tt.stationStops[x];
+        for (int y = tt.stationStopOffsets[to]; y < tt.stationStopOffsets[to + 1]; y++) {
+            auto [otherRoute, alightStop] = tt.stationStops[y];
+            if (otherRoute != route || alightStop <= boardStop) continue;
+            int trip = tt.earliestTrip(route, boardStop, time);
+            if (trip != -1) best = std::min(best, tt.arrival[tt.event(trip, alightStop)]);
+        }
+    }
+    return best == kNever ? -1 : best;
+}
+
+std::vector<PatternJourney> transferPatternQuery(const TransferPatterns &patterns, int source, int target,
+                                                 int departure) {
+    const Timetable &tt = patterns.timetable;
+    const int n = patterns.stationCount();
+    const PatternNode *nodes = &patterns.nodes[patterns.nodeOffsets[source]];
+    const size_t pair = (size_t)source * n + target;
+    std::vector<PatternJourney> journeys;
+    std::vector<int> chain;
+    for (int e = patterns.targetOffsets[pair]; e < patterns.targetOffsets[pair + 1]; e++) {
+        chain.clear();
+        for (int node = patterns.targetNodes[e]; node > 0; node = nodes[node].parent) chain.push_back(node);
+        int station = source, time = departure, readyTime = departure, trips = 0;
+        for (auto node = chain.rbegin(); node != chain.rend() && time != -1; ++node) {
+            const PatternNode &leg = nodes[*node];
+            if (leg.walk) {
+                int walk = -1;
+                for (int f = tt.footpathOffsets[station]; f < tt.footpathOffsets[station + 1]; f++) {
+                    if (tt.footpaths[f].to == leg.station) walk = tt.footpaths[f].time;
+                }
+                time = walk == -1 ? -1 : time + walk;
+                readyTime = time;
+            } else {
+                time = directConnection(tt, station, leg.station, readyTime);
+                readyTime = time + tt.transferTime;
+                trips++;
+            }
+            station = leg.station;
+        }
+        if (time != -1) journeys.push_back({time, trips});
+    }
+    // Fewest trips first, each kept only if it arrives earlier than all with fewer.
+    std::sort(journeys.begin(), journeys.end(), [](const PatternJourney &a, const PatternJourney &b) {
+        return a.trips != b.trips ? a.trips < b.trips : a.arrival < b.arrival;
+    });
+    std::vector<PatternJourney> pareto;
+    for (const PatternJourney &journey : journeys) {
+        if (pareto.empty() || journey.arrival < pareto.back().arrival) pareto.push_back(journey);
+    }
+    return pareto;
+}
+
+} // namespace subway
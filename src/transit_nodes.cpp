@@ -0,0 +1,255 @@
+#include "subway/transit_nodes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include <utility>
+
+namespace subway {
+
+namespace {
+
+const int kUnreached = std::numeric_limits<int>::max();
+
+// Line-graph CSR in one direction; the reverse direction swaps the edge ends.
+struct Adjacency {
+    std::vector<int> offsets;
+    std::vector<int> to;
+    std::vector<int> cost;
+};
+
+Adjacency reverseAdjacency(const LineGraph &lg) {
+    const int nodes = (int)lg.station.size();
+    Adjacency adj;
+    adj.offsets.assign(nodes + 1, 0);
+    for (int v : lg.to) adj.offsets[v + 1]++;
+    std::partial_sum(adj.offsets.begin(), adj.offsets.end(), adj.offsets.begin());
+    adj.to.resize(lg.to.size());
+    adj.cost.resize(lg.to.size());
+    std::vector<int> fill(adj.offsets.begin(), adj.offsets.end() - 1);
+    for (size_t x = 0; x < lg.to.size(); x++) {
+        int slot = fill[lg.to[x]]++;
+        adj.to[slot] = lg.from[x];
+        adj.cost[slot] = lg.cost[x];
+    }
+    return adj;
+}
+
+// Node range of a station: its start node followed by one node per arriving line.
+inline int firstNode(const LineGraph &lg, int station) {
+    return lg.startNode[station];
+}
+
+inline int endNode(const LineGraph &lg, int station) {
+    return station + 1 < (int)lg.startNode.size() ? lg.startNode[station + 1] : (int)lg.station.size();
+}
+
+typedef std::pair<int, int> QueueEntry; // {cost, node}
+
+// Search state reused across the access searches of one thread.
+struct CoverSearch {
+    std::vector<int> dist;
+    std::vector<char> covered;
+    std::vector<int> touched;
+};
+
+// Search from 'seeds' (at cost 0) that marks a node covered once its path passes a
+// hub node, and stops when only covered nodes are queued. Hub nodes whose path
+// reached them uncovered are the access entries; stations with an uncovered settled
+// node form the local area.
+void coverSearch(int nodes, const std::vector<int> &offsets, const std::vector<int> &to,
+                 const std::vector<int> &cost, const LineGraph &lg, const std::vector<int> &tableIndex,
+                 const std::vector<int> &seeds, CoverSearch &search, std::vector<AccessEntry> &entries,
+                 std::vector<int> &area) {
+    if (search.dist.empty()) {
+        search.dist.assign(nodes, kUnreached);
+        search.covered.assign(nodes, 0);
+    }
+    for (int v : search.touched) {
+        search.dist[v] = kUnreached;
+        search.covered[v] = 0;
+    }
+    search.touched.clear();
+    entries.clear();
+    area.clear();
+
+    // Queue entries carry the covered flag in the low bit of the node.
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+    int uncoveredQueued = 0;
+    for (int seed : seeds) {
+        search.dist[seed] = 0;
+        search.touched.push_back(seed);
+        pq.push({0, seed * 2});
+        uncoveredQueued++;
+    }
+    while (!pq.empty() && uncoveredQueued > 0) {
+        auto [d, entry] = pq.top();
+        pq.pop();
+        int v = entry >> 1;
+        if (!(entry & 1)) uncoveredQueued--;
+        if (d > search.dist[v]) continue;
+        bool coveredHere = search.covered[v];
+        if (!coveredHere) {
+            area.push_back(lg.station[v]);
+            if (tableIndex[v] >= 0) {
+                entries.push_back({tableIndex[v], d});
+                coveredHere = true;
+            }
+        }
+        for (int x = offsets[v]; x < offsets[v + 1]; x++) {
+            int w = to[x];
+            int nd = d + cost[x];
+            if (nd < search.dist[w]) {
+                if (search.dist[w] == kUnreached) search.touched.push_back(w);
+                search.dist[w] = nd;
+                search.covered[w] = coveredHere;
+                pq.push({nd, w * 2 + coveredHere});
+                if (!coveredHere) uncoveredQueued++;
+            }
+        }
+    }
+    std::sort(area.begin(), area.end());
+    area.erase(std::unique(area.begin(), area.end()), area.end());
+}
+
+} // namespace
+
+size_t TransitNodes::memoryBytes() const {
+    return table.size() * sizeof(int) + (access.size() + egress.size()) * sizeof(AccessEntry) +
+           (accessOffsets.size() + egressOffsets.size() + localOffsets.size() + local.size()) * sizeof(int);
+}
+
+TransitNodes buildTransitNodes(const GraphView &view, int transferCost, int hubCount, int samples, int threads) {
+    TransitNodes tnr;
+    const int n = (int)view.offsets.size() - 1;
+    threads = std::max(1, threads);
+    tnr.lineGraph = buildLineGraph(view, transferCost);
+    const LineGraph &lg = tnr.lineGraph;
+    const int nodes = (int)lg.station.size();
+
+    Centrality centrality = betweennessCentrality(view, transferCost, samples, 7, threads);
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    hubCount = std::max(0, std::min(hubCount, n));
+    std::partial_sort(order.begin(), order.begin() + hubCount, order.end(),
+                      [&](int a, int b) { return centrality.station[a] > centrality.station[b]; });
+    tnr.hubs.assign(order.begin(), order.begin() + hubCount);
+    std::sort(tnr.hubs.begin(), tnr.hubs.end());
+    std::vector<int> tableIndex(nodes, -1);
+    for (int h : tnr.hubs) {
+        for (int v = firstNode(lg, h); v < endNode(lg, h); v++) {
+            tableIndex[v] = (int)tnr.hubNodes.size();
+            tnr.hubNodes.push_back(v);
+        }
+    }
+    const int size = (int)tnr.hubNodes.size();
+    Adjacency reverse = reverseAdjacency(lg);
+
+    // Runs 'task' for items [0, count) on the worker threads.
+    auto parallelFor = [&](int count, const std::function<void(int, int)> &task) {
+        std::atomic<int> next(0);
+        auto worker = [&](int t) {
+            for (int i = next++; i < count; i = next++) task(t, i);
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+        worker(0);
+        for (auto &t : pool) t.join();
+    };
+
+    // Hub-to-hub table: one full search per hub node.
+    tnr.table.assign((size_t)size * size, kUnreached);
+    std::vector<std::vector<int>> dists(threads);
+    parallelFor(size, [&](int t, int row) {
+        std::vector<int> &dist = dists[t];
+        dist.assign(nodes, kUnreached);
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+        dist[tnr.hubNodes[row]] = 0;
+        pq.push({0, tnr.hubNodes[row]});
+        while (!pq.empty()) {
+            auto [d, v] = pq.top();
+            pq.pop();
+            if (d > dist[v]) continue;
+            for (int x = lg.offsets[v]; x < lg.offsets[v + 1]; x++) {
+                if (d + lg.cost[x] < dist[lg.to[x]]) {
+                    dist[lg.to[x]] = d + lg.cost[x];
+                    pq.push({dist[lg.to[x]], lg.to[x]});
+                }
+            }
+        }
+        for (int col = 0; col < size; col++) tnr.table[(size_t)row * size + col] = dist[tnr.hubNodes[col]];
+    });
+
+    // Access, egress and local areas, one pair of covering searches per station.
+    std::vector<std::vector<AccessEntry>> access(n), egress(n);
+    std::vector<std::vector<int>> localArea(n);
+    std::vector<CoverSearch> forward(threads), backward(threads);
+    parallelFor(n, [&](int t, int s) {
+        std::vector<int> area; // the backward area is not needed
+        coverSearch(nodes, lg.offsets, lg.to, lg.cost, lg, tableIndex, {lg.startNode[s]}, forward[t], access[s],
+                    localArea[s]);
+        // Trips end at any node of the station.
+        std::vector<int> seeds;
+        for (int v = firstNode(lg, s); v < endNode(lg, s); v++) seeds.push_back(v);
+        coverSearch(nodes, reverse.offsets, reverse.to, reverse.cost, lg, tableIndex, seeds, backward[t], egress[s],
+                    area);
+    });
+    auto flatten = [](auto &lists, auto &offsets, auto &flat) {
+        offsets.assign(1, 0);
+        for (auto &list : lists) {
+            flat.insert(flat.end(), list.begin(), list.end());
+            offsets.push_back((int)flat.size());
+        }
+    };
+    flatten(access, tnr.accessOffsets, tnr.access);
+    flatten(egress, tnr.egressOffsets, tnr.egress);
+    flatten(localArea, tnr.localOffsets, tnr.local);
+    return tnr;
+}
+
+int lineGraphCost(const LineGraph &lg, int source, int destination) {
+    const int nodes = (int)lg.station.size();
+    std::vector<int> dist(nodes, kUnreached);
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+    dist[lg.startNode[source]] = 0;
+    pq.push({0, lg.startNode[source]});
+    while (!pq.empty()) {
+        auto [d, v] = pq.top();
+        pq.pop();
+        if (d > dist[v]) continue;
+        if (lg.station[v] == destination) return d;
+        for (int x = lg.offsets[v]; x < lg.offsets[v + 1]; x++) {
+            if (d + lg.cost[x] < dist[lg.to[x]]) {
+                dist[lg.to[x]] = d + lg.cost[x];
+                pq.push({dist[lg.to[x]], lg.to[x]});
+            }
+        }
+    }
+    return -1;
+}
+
+int transitNodeCost(const TransitNodes &tnr, int source, int destination, bool *local) {
+    auto begin = tnr.local.begin() + tnr.localOffsets[source], end = tnr.local.begin() + tnr.localOffsets[source + 1];
+    bool near = std::binary_search(begin, end, destination);
+    if (local) *local = near;
+    if (near) return lineGraphCost(tnr.lineGraph, source, destination);
+
+    const size_t size = tnr.hubNodes.size();
+    int best = kUnreached;
+    for (int a = tnr.accessOffsets[source]; a < tnr.accessOffsets[source + 1]; a++) {
+        const AccessEntry &from = tnr.access[a];
+        const int *row = &tnr.table[from.hub * size];
+        for (int b = tnr.egressOffsets[destination]; b < tnr.egressOffsets[destination + 1]; b++) {
+            const AccessEntry &to = tnr.egress[b];
+            if (row[to.hub] == kUnreached) continue;
+            best = std::min(best, from.cost + row[to.hub] + to.cost);
+        }
+    }
+    return best == kUnreached ? -1 : best;
+}
+
+} // namespace subway
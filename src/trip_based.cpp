@@ -0,0 +1,321 @@
+#include "subway/trip_based.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <utility>
+
+namespace subway {
+
+namespace {
+
+const int kNever = std::numeric_limits<int>::max();
+
+// Earliest arrival and earliest boarding time per station while one trip is
+// reduced, reset through the list of touched stations.
+struct ReductionLabels {
+    std::vector<int> arrival;
+    std::vector<int> ready;
+    std::vector<int> touched;
+
+    explicit ReductionLabels(int n) : arrival(n, kNever), ready(n, kNever) {}
+
+    void reset() {
+        for (int s : touched) arrival[s] = ready[s] = kNever;
+        touched.clear();
+    }
+
+    // Records arriving at 'station' by vehicle at 'time'; returns whether any label improved.
+    bool arrive(const Timetable &tt, int station, int time) {
+        bool improved = improve(station, time, time + tt.transferTime);
+        for (int f = tt.footpathOffsets[station]; f < tt.footpathOffsets[station + 1]; f++) {
+            const Footpath &walk = tt.footpaths[f];
+            improved |= improve(walk.to, time + walk.time, time + walk.time);
+        }
+        return improved;
+    }
+
+    bool improve(int station, int arrive, int board) {
+        if (arrival[station] == kNever && ready[station] == kNever) touched.push_back(station);
+        bool improved = false;
+        if (arrive < arrival[station]) {
+            arrival[station] = arrive;
+            improved = true;
+        }
+        if (board < ready[station]) {
+            ready[station] = board;
+            improved = true;
+        }
+        return improved;
+    }
+};
+
+// Transfers of one trip as {stop index, transfer}, in stop order.
+void tripTransfers(const Timetable &tt, int t, ReductionLabels &labels,
+                   std::vector<std::pair<int, TripTransfer>> &out) {
+    const int route = tt.tripRoute[t];
+    const int m = tt.stopCount(route);
+    const int *stops = &tt.routeStops[tt.routeStopOffsets[route]];
+    labels.reset();
+    out.clear();
+    std::vector<TripTransfer> candidates;
+    for (int i = m - 1; i >= 1; i--) {
+        const int p = stops[i];
+        const int arrival = tt.arrival[tt.event(t, i)];
+        labels.arrive(tt, p, arrival);
+
+        // Earliest trip of every route from this station or one footpath away.
+        candidates.clear();
+        auto consider = [&](int station, int ready, bool sameStation) {
+            for (int x = tt.stationStopOffsets[station]; x < tt.stationStopOffsets[station + 1]; x++) {
+                auto [r, j] = tt.stationStops[x];
+                const int rStops = tt.stopCount(r);
+                if (j == rStops - 1) continue;
+                int u = tt.earliestTrip(r, j, ready);
+                if (u == -1) continue;
+                // Staying seated is at least as good.
+                if (sameStation && r == route && u >= t && j >= i) continue;
+                // U-turn: the trip goes back to the previous stop, where changing was possible too.
+                if (sameStation && tt.routeStops[tt.routeStopOffsets[r] + j + 1] == stops[i - 1] &&
+                    tt.arrival[tt.event(t, i - 1)] + tt.transferTime <= tt.departure[tt.event(u, j + 1)])
+                    continue;
+                candidates.push_back({u, j});
+            }
+        };
+        consider(p, arrival + tt.transferTime, true);
+        for (int f = tt.footpathOffsets[p]; f < tt.footpathOffsets[p + 1]; f++)
+            consider(tt.footpaths[f].to, arrival + tt.footpaths[f].time, false);
+        std::sort(candidates.begin(), candidates.end(), [&](const TripTransfer &a, const TripTransfer &b) {
+            return tt.departure[tt.event(a.trip, a.stop)] < tt.departure[tt.event(b.trip, b.stop)];
+        });
+
+        // Keep a transfer only if riding on improves some arrival or boarding time
+        // over staying on this trip, later transfers from it, and transfers kept so far.
+        for (const TripTransfer &transfer : candidates) {
+            const int uRoute = tt.tripRoute[transfer.trip];
+            const int *uStops = &tt.routeStops[tt.routeStopOffsets[uRoute]];
+            bool keep = false;
+            for (int k = transfer.stop + 1; k < tt.stopCount(uRoute); k++)
+                keep |= labels.arrive(tt, uStops[k], tt.arrival[tt.event(transfer.trip, k)]);
+            if (keep) out.push_back({i, transfer});
+        }
+    }
+    std::reverse(out.begin(), out.end());
+    std::stable_sort(out.begin(), out.end(),
+                     [](const std::pair<int, TripTransfer> &a, const std::pair<int, TripTransfer> &b) {
+                         return a.first < b.first;
+                     });
+}
+
+} // namespace
+
+size_t TripBased::memoryBytes() const {
+    return timetable.memoryBytes() + transferOffsets.size() * sizeof(int) + transfers.size() * sizeof(TripTransfer);
+}
+
+TripBased buildTripBased(Timetable timetable, int threads) {
+    TripBased tb;
+    tb.timetable = std::move(timetable);
+    const Timetable &tt = tb.timetable;
+    const int trips = tt.tripCount();
+    const int n = (int)tt.stationStopOffsets.size() - 1;
+
+    std::vector<std::vector<std::pair<int, TripTransfer>>> perTrip(trips);
+    threads = std::max(1, threads);
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        ReductionLabels labels(n);
+        for (int t = next++; t < trips; t = next++) tripTransfers(tt, t, labels, perTrip[t]);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+
+    tb.transferOffsets.assign(tt.arrival.size() + 1, 0);
+    for (int t = 0; t < trips; t++) {
+        for (const auto &[stop, transfer] : perTrip[t]) tb.transferOffsets[tt.event(t, stop) + 1]++;
+    }
+    for (size_t e = 0; e + 1 < tb.transferOffsets.size(); e++) tb.transferOffsets[e + 1] += tb.transferOffsets[e];
+    tb.transfers.reserve(tb.transferOffsets.back());
+    for (int t = 0; t < trips; t++) {
+        for (const auto &entry : perTrip[t]) tb.transfers.push_back(entry.second);
+        std::vector<std::pair<int, TripTransfer>>().swap(perTrip[t]);
+    }
+    return tb;
+}
+
+TripBasedQuery::TripBasedQuery(const TripBased &tripBased)
+    : tb(tripBased), bestArrival(kMaxTrips + 1, kNever), queue(kMaxTrips + 1),
+      targetStops(tripBased.timetable.routeCount()) {
+    const Timetable &tt = tb.timetable;
+    reachedStop.resize((size_t)tt.tripCount() * kMaxTrips);
+    for (int t = 0; t < tt.tripCount(); t++)
+        std::fill_n(&reachedStop[(size_t)t * kMaxTrips], kMaxTrips, tt.stopCount(tt.tripRoute[t]));
+}
+
+void TripBasedQuery::reset() {
+    const Timetable &tt = tb.timetable;
+    for (int t : touchedTrips)
+        std::fill_n(&reachedStop[(size_t)t * kMaxTrips], kMaxTrips, tt.stopCount(tt.tripRoute[t]));
+    touchedTrips.clear();
+    std::fill(bestArrival.begin(), bestArrival.end(), kNever);
+    for (int route : targetRoutes) targetStops[route].clear();
+    targetRoutes.clear();
+}
+
+void TripBasedQuery::enqueue(int trip, int stop, int level) {
+    const Timetable &tt = tb.timetable;
+    // Earliest arrival needs one label per trip; profiles keep one per trip count.
+    const int slot = levels == 1 ? 0 : level - 1;
+    int *reached = &reachedStop[(size_t)trip * kMaxTrips];
+    if (stop >= reached[slot]) return;
+    queue[level].push_back({trip, stop, std::min(reached[slot], tt.stopCount(tt.tripRoute[trip]) - 1)});
+    // Later trips of the route are reached from this stop too, with as many trips or more.
+    const int route = tt.tripRoute[trip];
+    const int stops = tt.stopCount(route);
+    for (int u = trip; u < tt.routeTripOffsets[route + 1]; u++) {
+        reached = &reachedStop[(size_t)u * kMaxTrips];
+        if (reached[slot] <= stop) break;
+        if (reached[levels - 1] == stops) touchedTrips.push_back(u);
+        for (int l = slot; l < levels && reached[l] > stop; l++) reached[l] = stop;
+    }
+}
+
+void TripBasedQuery::scan(int source, int target, int departure, std::vector<ProfileEntry> *found) {
+    const Timetable &tt = tb.timetable;
+    auto improve = [&](int trips, int arrival) {
+        if (arrival >= bestArrival[trips]) return;
+        for (int l = trips; l <= kMaxTrips; l++) bestArrival[l] = std::min(bestArrival[l], arrival);
+        if (found) found->push_back({departure, arrival, std::max(0, trips - 1)});
+    };
+
+    // Walking only.
+    if (source == target) improve(0, departure);
+    for (int f = tt.footpathOffsets[source]; f < tt.footpathOffsets[source + 1]; f++)
+        if (tt.footpaths[f].to == target) improve(0, departure + tt.footpaths[f].time);
+
+    auto board = [&](int station, int ready) {
+        for (int x = tt.stationStopOffsets[station]; x < tt.stationStopOffsets[station + 1]; x++) {
+            auto [route, stop] = tt.stationStops[x];
+            int trip = tt.earliestTrip(route, stop, ready);
+            if (trip != -1) enqueue(trip, stop, 1);
+        }
+    };
+    board(source, departure);
+    for (int f = tt.footpathOffsets[source]; f < tt.footpathOffsets[source + 1]; f++)
+        board(tt.footpaths[f].to, departure + tt.footpaths[f].time);
+
+    for (int level = 1; level <= kMaxTrips; level++) {
+        for (const Segment &segment : queue[level]) {
+            const int route = tt.tripRoute[segment.trip];
+            for (const TargetStop &exit : targetStops[route]) {
+                if (exit.stop > segment.from && exit.stop <= segment.to)
+                    improve(level, tt.arrival[tt.event(segment.trip, exit.stop)] + exit.delay);
+            }
+        }
+        if (level == kMaxTrips) break;
+        for (const Segment &segment : queue[level]) {
+            for (int i = segment.from + 1; i <= segment.to; i++) {
+                const int event = tt.event(segment.trip, i);
+                // Anything boarded from here arrives no earlier than this.
+                if (tt.arrival[event] >= bestArrival[levels == 1 ? kMaxTrips : level + 1]) break;
+                for (int x = tb.transferOffsets[event]; x < tb.transferOffsets[event + 1]; x++)
+                    enqueue(tb.transfers[x].trip, tb.transfers[x].stop, level + 1);
+            }
+        }
+        queue[level].clear();
+    }
+    queue[kMaxTrips].clear();
+}
+
+void TripBasedQuery::setTarget(int target) {
+    const Timetable &tt = tb.timetable;
+    auto addTarget = [&](int station, int delay) {
+        for (int x = tt.stationStopOffsets[station]; x < tt.stationStopOffsets[station + 1]; x++) {
+            auto [route, stop] = tt.stationStops[x];
+            if (targetStops[route].empty()) targetRoutes.push_back(route);
+            targetStops[route].push_back({stop, delay});
+        }
+    };
+    addTarget(target, 0);
+    for (int s = 0; s + 1 < (int)tt.footpathOffsets.size(); s++) {
+        for (int f = tt.footpathOffsets[s]; f < tt.footpathOffsets[s + 1]; f++)
+            if (tt.footpaths[f].to == target) addTarget(s, tt.footpaths[f].time);
+    }
+}
+
+int TripBasedQuery::earliestArrival(int source, int target, int departure, int *transfers) {
+    reset();
+    levels = 1;
+    setTarget(target);
+    scan(source, target, departure, nullptr);
+    int best = bestArrival[kMaxTrips];
+    if (best == kNever) return -1;
+    if (transfers) {
+        int trips = 0;
+        while (bestArrival[trips] != best) trips++;
+        *transfers = std::max(0, trips - 1);
+    }
+    return best;
+}
+
+std::vector<ProfileEntry> TripBasedQuery::profile(int source, int target, int from, int to) {
+    const Timetable &tt = tb.timetable;
+    reset();
+    levels = kMaxTrips;
+    setTarget(target);
+
+    // Every time a trip can be boarded from the source within the range.
+    std::vector<int> departures;
+    auto collect = [&](int station, int walk) {
+        for (int x = tt.stationStopOffsets[station]; x < tt.stationStopOffsets[station + 1]; x++) {
+            auto [route, stop] = tt.stationStops[x];
+            for (int trip = tt.routeTripOffsets[route]; trip < tt.routeTripOffsets[route + 1]; trip++) {
+                int time = tt.departure[tt.event(trip, stop)] - walk;
+                if (time >= from && time <= to) departures.push_back(time);
+            }
+        }
+    };
+    // The latest departure also covers walking to the target.
+    departures.push_back(to);
+    collect(source, 0);
+    for (int f = tt.footpathOffsets[source]; f < tt.footpathOffsets[source + 1]; f++)
+        collect(tt.footpaths[f].to, tt.footpaths[f].time);
+    std::sort(departures.begin(), departures.end(), std::greater<int>());
+    departures.erase(std::unique(departures.begin(), departures.end()), departures.end());
+    std::vector<ProfileEntry> candidates;
+    for (int departure : departures) scan(source, target, departure, &candidates);
+
+    // Bounds carried from later departures leave only improvements; drop entries
+    // superseded within the same departure.
+    std::vector<ProfileEntry> found;
+    auto order = [](const ProfileEntry &a, const ProfileEntry &b) {
+        if (a.departure != b.departure) return a.departure > b.departure;
+        if (a.arrival != b.arrival) return a.arrival < b.arrival;
+        return a.transfers < b.transfers;
+    };
+    std::sort(candidates.begin(), candidates.end(), order);
+    for (const ProfileEntry &entry : candidates) {
+        if (found.empty() || order(found.back(), entry)) found.push_back(entry);
+    }
+    std::vector<ProfileEntry> pareto;
+    for (const ProfileEntry &entry : found) {
+        bool dominated = false;
+        for (const ProfileEntry &other : found) {
+            if (&other == &entry) continue;
+            if (other.departure >= entry.departure && other.arrival <= entry.arrival &&
+                other.transfers <= entry.transfers &&
+                (other.departure > entry.departure || other.arrival < entry.arrival ||
+                 other.transfers < entry.transfers)) {
+                dominated = true;
+                break;
+            }
+        }
+        if (!dominated) pareto.push_back(entry);
+    }
+    return pareto;
+}
+
+} // namespace subway
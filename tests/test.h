@@ -0,0 +1,48 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal test registry: TEST(suite, name) defines a test, CHECK/CHECK_EQ record
+// failures without stopping it. The runner takes a suite name and runs its tests.
+namespace subway_test {
+
+struct TestCase {
+    const char *suite;
+    const char *name;
+    void (*run)();
+};
+
+std::vector<TestCase> &registry();
+extern int failures;
+
+struct Registration {
+    Registration(const char *suite, const char *name, void (*run)()) { registry().push_back({suite, name, run}); }
+};
+
+} // namespace subway_test
+
+#define TEST(suite, name)                                                                            \
+    static void suite##_##name();                                                                   \
+    static subway_test::Registration suite##_##name##_registration(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition)                                                                      \
+    do {                                                                                      \
+        if (!(condition)) {                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition "\n"; \
+            subway_test::failures++;                                                          \
+        }                                                                                     \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                    \
+    do {                                                                                              \
+        auto actualValue = (actual);                                                                  \
+        auto expectedValue = (expected);                                                              \
+        if (!(actualValue == expectedValue)) {                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ failed: " #actual " == " #expected \
+                      << " (" << actualValue << " vs " << expectedValue << ")\n";                    \
+            subway_test::failures++;                                                                  \
+        }                                                                                             \
+    } while (0)
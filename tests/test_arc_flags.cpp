@@ -0,0 +1,47 @@
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+// Number of station pairs where the flagged search differs from findPath.
+int mismatches(const GraphView &view, int transferCost, int regions) {
+    ArcFlags arcFlags = buildArcFlags(view, transferCost, regions, 2);
+    int n = (int)view.offsets.size() - 1, differ = 0;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            PackedPath plain = findPath(view, s, t, transferCost);
+            PackedPath flagged = findPathArcFlags(view, arcFlags, s, t, transferCost);
+            differ += plain.cost != flagged.cost || plain.edges != flagged.edges;
+        }
+    }
+    return differ;
+}
+
+} // namespace
+
+TEST(arc_flags, samplePathsMatchFindPath) {
+    Graph graph;
+    buildSampleGraph(graph);
+    for (int regions : {1, 3, 8}) CHECK_EQ(mismatches(graph.view(0), 2, regions), 0);
+}
+
+TEST(arc_flags, gridPathsMatchFindPath) {
+    Graph graph;
+    generateCityNetwork(graph, 10, 10, 7);
+    CHECK_EQ(mismatches(graph.view(0), 5, 16), 0);
+    CHECK_EQ(mismatches(graph.view(0), 0, 64), 0);
+}
+
+// A one-way edge leaves part of the pairs unreachable; both searches agree on that.
+TEST(arc_flags, unreachablePairs) {
+    Graph graph;
+    graph.addBidirectionalEdge("A", "B", 2, "1");
+    graph.addEdge("B", "C", 3, "2");
+    graph.addBidirectionalEdge("C", "D", 1, "2");
+    graph.finalize();
+    CHECK_EQ(mismatches(graph.view(0), 2, 2), 0);
+    ArcFlags arcFlags = buildArcFlags(graph.view(0), 2, 2, 1);
+    CHECK_EQ(findPathArcFlags(graph.view(0), arcFlags, graph.findStation("D"), graph.findStation("A"), 2).cost, -1);
+}
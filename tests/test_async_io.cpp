@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+// Writes 'size' pattern bytes in uneven pieces through small chunks and reads
+// them back.
+void roundTrip(const char *path, size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = (uint8_t)(i * 131 + i / 7);
+    std::string error;
+    ChunkWriter writer(4096);
+    CHECK(writer.open(path, error));
+    for (size_t at = 0, piece = 1; at < size; at += piece, piece = piece * 3 % 5000 + 1)
+        CHECK(writer.write(data.data() + at, std::min(piece, size - at), error));
+    CHECK(writer.close(error));
+    CHECK_EQ(writer.bytesWritten(), (uint64_t)size);
+
+    ChunkReader reader(3000);
+    CHECK(reader.open(path, error));
+    std::vector<uint8_t> back;
+    const uint8_t *chunk;
+    size_t chunkSize;
+    while (reader.next(chunk, chunkSize, error)) back.insert(back.end(), chunk, chunk + chunkSize);
+    CHECK(error.empty());
+    CHECK(back == data);
+    std::remove(path);
+}
+
+} // namespace
+
+TEST(async_io, chunkRoundTrip) {
+    roundTrip("async_io_test.bin", 100000);
+    roundTrip("async_io_test.bin", 4096);
+    roundTrip("async_io_test.bin", 1);
+}
+
+TEST(async_io, chunkRoundTripWithoutUring) {
+    setenv("SUBWAY_NO_URING", "1", 1);
+    roundTrip("async_io_test.bin", 100000);
+    unsetenv("SUBWAY_NO_URING");
+}
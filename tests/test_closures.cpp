@@ -0,0 +1,97 @@
+#include <limits>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+// Impact of every closure computed by re-searching every origin.
+std::vector<ClosureImpact> recomputeClosures(const GraphView &view, const std::vector<OdDemand> &demand,
+                                             int transferCost) {
+    const int INF = std::numeric_limits<int>::max();
+    std::vector<ClosureImpact> impacts;
+    SearchTree base, closed;
+    for (const std::vector<int> &segment : viewSegments(view)) {
+        ClosureImpact impact;
+        impact.edges = segment;
+        std::vector<int> costs(view.edges.size());
+        for (size_t e = 0; e < costs.size(); e++) costs[e] = view.edges[e].cost;
+        for (int e : segment) costs[e] = -1;
+        for (const OdDemand &od : demand) {
+            buildSearchTree(view, od.origin, transferCost, base);
+            buildSearchTree(view, od.origin, transferCost, closed, &costs);
+            int before = base.dist[od.destination], after = closed.dist[od.destination];
+            if (before == after) continue;
+            impact.affectedTrips += od.trips;
+            if (after == INF) impact.unservedTrips += od.trips;
+            else if (before != INF) impact.extraCost += od.trips * (after - before);
+        }
+        impacts.push_back(impact);
+    }
+    return impacts;
+}
+
+void checkAgainstRecompute(const GraphView &view, const std::vector<OdDemand> &demand, int transferCost) {
+    std::vector<ClosureImpact> fast = simulateClosures(view, demand, transferCost, 2);
+    std::vector<ClosureImpact> full = recomputeClosures(view, demand, transferCost);
+    CHECK_EQ(fast.size(), full.size());
+    for (size_t c = 0; c < fast.size() && c < full.size(); c++) {
+        CHECK(fast[c].edges == full[c].edges);
+        CHECK_EQ(fast[c].affectedTrips, full[c].affectedTrips);
+        CHECK_EQ(fast[c].unservedTrips, full[c].unservedTrips);
+        CHECK_EQ(fast[c].extraCost, full[c].extraCost);
+    }
+}
+
+} // namespace
+
+// Closing A moves Y onto line B, which makes O -> D via Y cheaper than line C
+// although no edge of the O -> D path was closed.
+TEST(closures, lineChangeElsewhereLowersCost) {
+    Graph graph;
+    graph.addBidirectionalEdge("O", "Y", 1, "A");
+    graph.addBidirectionalEdge("O", "Y", 2, "B");
+    graph.addBidirectionalEdge("Y", "D", 1, "B");
+    graph.addBidirectionalEdge("O", "D", 6, "C");
+    graph.finalize();
+    const GraphView &view = graph.view(0);
+    std::vector<OdDemand> demand = {{graph.findStation("O"), graph.findStation("D"), 1}};
+    std::vector<ClosureImpact> impacts = simulateClosures(view, demand, 5, 1);
+    int lineA = graph.findLine("A");
+    bool found = false;
+    for (const ClosureImpact &impact : impacts) {
+        if (view.edges[impact.edges[0]].lineId != lineA) continue;
+        found = true;
+        CHECK_EQ(impact.affectedTrips, 1.0);
+        CHECK_EQ(impact.extraCost, -3.0);
+    }
+    CHECK(found);
+    checkAgainstRecompute(view, demand, 5);
+}
+
+TEST(closures, gridMatchesRecompute) {
+    Graph graph;
+    generateCityNetwork(graph, 5, 5, 3);
+    const GraphView &view = graph.view(0);
+    std::vector<OdDemand> demand;
+    int n = (int)graph.stationNames.size();
+    for (int o = 0; o < n; o += 2)
+        for (int d = 0; d < n; d += 3)
+            if (o != d) demand.push_back({o, d, 1.0 + (o + d) % 4});
+    checkAgainstRecompute(view, demand, 2);
+    checkAgainstRecompute(view, demand, 7);
+}
+
+TEST(closures, sampleMatchesRecompute) {
+    Graph graph;
+    buildSampleGraph(graph);
+    const GraphView &view = graph.view(0);
+    std::vector<OdDemand> demand;
+    int n = (int)graph.stationNames.size();
+    for (int o = 0; o < n; o++)
+        for (int d = 0; d < n; d++)
+            if (o != d) demand.push_back({o, d, 1});
+    checkAgainstRecompute(view, demand, 2);
+}
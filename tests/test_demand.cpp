@@ -0,0 +1,48 @@
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+// A walk between two lines is neither a boarding nor a line of its own, and a
+// pair whose origin is its destination contributes nothing.
+TEST(demand, walkingLegsAndSelfPairsAreNotBoardings) {
+    Graph graph;
+    graph.addBidirectionalEdge("A", "B", 3, "1");
+    graph.addBidirectionalEdge("B", "C", 1, "Interchange");
+    graph.addBidirectionalEdge("C", "D", 3, "2");
+    graph.finalize();
+    int a = graph.findStation("A"), c = graph.findStation("C"), d = graph.findStation("D");
+    std::vector<OdDemand> demand = {{a, d, 10}, {a, a, 5}, {d, d, 7}, {c, d, 2}};
+    for (int threads : {1, 3}) {
+        FlowReport report = aggregateFlows(graph.view(0), demand, 2, graph.lineNames.size(),
+                                           graph.findLine("Interchange"), threads);
+        CHECK_EQ(report.boardings[graph.findLine("1")], 10.0);
+        CHECK_EQ(report.boardings[graph.findLine("2")], 12.0);
+        CHECK_EQ(report.boardings[graph.findLine("Interchange")], 0.0);
+        CHECK_EQ(report.unrouted, 0.0);
+        double total = 0;
+        for (double flow : report.edgeFlow) total += flow;
+        CHECK_EQ(total, 32.0);
+    }
+}
+
+// Changing lines through a walked interchange is one transfer, counted where the
+// second line is boarded; walking back onto the same line is no transfer at all.
+TEST(demand, walkedInterchangeIsOneTransfer) {
+    Graph graph;
+    graph.addBidirectionalEdge("A", "B", 3, "1");
+    graph.addBidirectionalEdge("B", "C", 1, "Interchange");
+    graph.addBidirectionalEdge("C", "D", 3, "2");
+    graph.addBidirectionalEdge("D", "E", 1, "Interchange");
+    graph.addBidirectionalEdge("E", "F", 3, "2");
+    graph.finalize();
+    int a = graph.findStation("A"), c = graph.findStation("C"), f = graph.findStation("F");
+    std::vector<OdDemand> demand = {{a, f, 10}, {c, f, 4}};
+    FlowReport report = aggregateFlows(graph.view(0), demand, 2, graph.lineNames.size(),
+                                       graph.findLine("Interchange"), 1);
+    double total = 0;
+    for (double t : report.transfers) total += t;
+    CHECK_EQ(total, 10.0);
+    CHECK_EQ(report.transfers[c], 10.0);
+    CHECK_EQ(report.boardings[graph.findLine("2")], 28.0);
+}
@@ -0,0 +1,55 @@
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+// Two direct lines from S to D: A is faster and cheaper, so B's route is dominated.
+TEST(fares, dominatedRouteIsDropped) {
+    Graph graph;
+    graph.addBidirectionalEdge("S", "D", 10, "A");
+    graph.addBidirectionalEdge("S", "D", 12, "B");
+    graph.finalize();
+    FareModel fares = graph.makeFareModel(290, 120);
+    fares.surcharge[graph.findLine("B")] = 100;
+    std::vector<FareRoute> routes = graph.fareAwareRoutes("S", "D", 2, fares, graph.view(0));
+    CHECK_EQ(routes.size(), 1u);
+    if (!routes.empty()) {
+        CHECK_EQ(routes[0].time, 10);
+        CHECK_EQ(routes[0].fare, 290);
+    }
+}
+
+// A slower line without the surcharge is a genuine trade-off and stays.
+TEST(fares, tradeOffIsKept) {
+    Graph graph;
+    graph.addBidirectionalEdge("S", "D", 10, "A");
+    graph.addBidirectionalEdge("S", "D", 12, "B");
+    graph.finalize();
+    FareModel fares = graph.makeFareModel(290, 120);
+    fares.surcharge[graph.findLine("A")] = 100;
+    std::vector<FareRoute> routes = graph.fareAwareRoutes("S", "D", 2, fares, graph.view(0));
+    CHECK_EQ(routes.size(), 2u);
+    if (routes.size() == 2) {
+        CHECK_EQ(routes[0].time, 10);
+        CHECK_EQ(routes[0].fare, 390);
+        CHECK_EQ(routes[1].time, 12);
+        CHECK_EQ(routes[1].fare, 290);
+    }
+}
+
+// Every result on the sample network is strictly faster and dearer than the next.
+TEST(fares, sampleRoutesArePareto) {
+    Graph graph;
+    buildSampleGraph(graph);
+    FareModel fares = buildSampleFares(graph);
+    for (const std::string &from : graph.stationNames) {
+        for (const std::string &to : graph.stationNames) {
+            std::vector<FareRoute> routes = graph.fareAwareRoutes(from, to, 2, fares, graph.view(0));
+            for (size_t i = 1; i < routes.size(); i++) {
+                CHECK(routes[i - 1].time < routes[i].time);
+                CHECK(routes[i - 1].fare > routes[i].fare);
+            }
+            if (from != to) CHECK(!routes.empty());
+        }
+    }
+}
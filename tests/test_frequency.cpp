@@ -0,0 +1,61 @@
+#include <limits>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+TEST(frequency, headwayBandsWrapAroundTheDay) {
+    Graph graph;
+    graph.addBidirectionalEdge("S", "D", 5, "A");
+    graph.addBidirectionalEdge("S", "D", 1, "Interchange");
+    graph.finalize();
+    FrequencyModel frequencies = graph.makeFrequencyModel(8);
+    int line = graph.findLine("A");
+    frequencies.setBands(line, {{420, 4}, {0, 20}, {600, 0}});
+    CHECK_EQ(frequencies.headway(line, 0), 20);
+    CHECK_EQ(frequencies.headway(line, 419), 20);
+    CHECK_EQ(frequencies.headway(line, 420), 4);
+    CHECK_EQ(frequencies.headway(line, 420 + 1440), 4);
+    // Negative times belong to the previous day: -60 is 23:00.
+    CHECK_EQ(frequencies.headway(line, -60), 0);
+    CHECK_EQ(frequencies.headway(line, -1440 + 450), 4);
+    CHECK_EQ(frequencies.expectedWait(line, 430), 2);
+    CHECK_EQ(frequencies.expectedWait(line, 100), 10);
+    CHECK_EQ(frequencies.expectedWait(line, 700), std::numeric_limits<int>::max());
+    CHECK_EQ(frequencies.headway(graph.findLine("Interchange"), 100), -1);
+    CHECK_EQ(frequencies.expectedWait(graph.findLine("Interchange"), 100), 0);
+}
+
+// Unpacked legs of a frequency-based path add up to its expected journey time.
+TEST(frequency, unpackedLegsIncludeWaits) {
+    Graph graph;
+    buildSampleGraph(graph);
+    FrequencyModel frequencies = buildSampleFrequencies(graph);
+    const GraphView &view = graph.view(0);
+    int n = (int)graph.stationNames.size();
+    for (int departure : {30, 400, 450, 700, 1000, 1300}) {
+        for (int s = 0; s < n; s++) {
+            for (int t = 0; t < n; t++) {
+                PackedPath path = findPath(view, s, t, 2, frequencies, departure);
+                Route route = findRoute(view, s, t, 2, frequencies, departure);
+                CHECK_EQ(path.cost, route.cost);
+                if (path.cost <= 0) continue;
+                std::vector<PathLeg> legs = unpackPath(view, path, 2);
+                CHECK_EQ(legs.size(), path.waits.size());
+                CHECK_EQ(legs.back().cumulativeCosts.back(), path.cost);
+                int legTotal = 0;
+                for (const PathLeg &leg : legs) {
+                    CHECK(leg.wait >= 0);
+                    legTotal += leg.segmentCosts.size() ? leg.transferPenalty + leg.wait : 0;
+                    for (int c : leg.segmentCosts) legTotal += c;
+                }
+                CHECK_EQ(legTotal, path.cost);
+            }
+        }
+    }
+    // Static paths carry no waits.
+    PackedPath plain = findPath(view, 0, 6, 2);
+    CHECK(plain.waits.empty());
+    CHECK_EQ(unpackPath(view, plain, 2).back().cumulativeCosts.back(), plain.cost);
+}
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+bool sameTimetable(const Timetable &a, const Timetable &b) {
+    return a.transferTime == b.transferTime && a.routeLine == b.routeLine && a.routeStopOffsets == b.routeStopOffsets &&
+           a.routeStops == b.routeStops && a.routeTripOffsets == b.routeTripOffsets && a.tripRoute == b.tripRoute &&
+           a.tripEventOffsets == b.tripEventOffsets && a.arrival == b.arrival && a.departure == b.departure &&
+           a.stationStopOffsets == b.stationStopOffsets && a.stationStops == b.stationStops &&
+           a.footpathOffsets == b.footpathOffsets && a.footpaths.size() == b.footpaths.size();
+}
+
+} // namespace
+
+TEST(graph_file, sampleRoundTrip) {
+    const char *path = "graph_file_test.sgf";
+    Graph graph, loaded;
+    buildSampleGraph(graph);
+    std::string error;
+    TripBased none;
+    CHECK(saveGraph(graph, path, error));
+    CHECK(loadGraph(loaded, path, error, &none));
+    CHECK(loaded.stationNames == graph.stationNames);
+    CHECK(loaded.lineNames == graph.lineNames);
+    CHECK_EQ(loaded.edgeCount, graph.edgeCount);
+    CHECK(none.timetable.tripRoute.empty());
+    for (size_t s = 0; s < graph.stationNames.size(); s++) CHECK_EQ(loaded.findStation(graph.stationNames[s]), (int)s);
+    for (size_t l = 0; l < graph.lineNames.size(); l++) CHECK_EQ(loaded.findLine(graph.lineNames[l]), (int)l);
+    CHECK_EQ(loaded.findStation("No Such Station"), -1);
+    int n = (int)graph.stationNames.size(), differ = 0;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            PackedPath a = findPath(graph.view(0), s, t, 2), b = findPath(loaded.view(0), s, t, 2);
+            differ += a.cost != b.cost || a.edges != b.edges;
+        }
+    }
+    CHECK_EQ(differ, 0);
+    std::remove(path);
+}
+
+TEST(graph_file, tripBasedSectionRoundTrip) {
+    const char *path = "graph_file_test.sgf";
+    Graph graph, loaded;
+    generateCityNetwork(graph, 5, 5, 7);
+    TripBased tb = buildTripBased(buildTimetable(graph, graph.view(0), 6, 300, 1440, 2), 2), back;
+    std::string error;
+    CHECK(saveGraph(graph, path, error, &tb));
+    CHECK(loadGraph(loaded, path, error, &back));
+    CHECK(loaded.stationNames == graph.stationNames);
+    CHECK(sameTimetable(back.timetable, tb.timetable));
+    CHECK(back.transferOffsets == tb.transferOffsets);
+    CHECK_EQ(back.transfers.size(), tb.transfers.size());
+    TripBasedQuery before(tb), after(back);
+    int n = (int)graph.stationNames.size(), differ = 0;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) differ += before.earliestArrival(s, t, 480) != after.earliestArrival(s, t, 480);
+    }
+    CHECK_EQ(differ, 0);
+    std::remove(path);
+}
+
+// Every proper prefix of a valid file is rejected with an error.
+TEST(graph_file, truncatedFileIsRejected) {
+    const char *path = "graph_file_test.sgf";
+    Graph graph;
+    buildSampleGraph(graph);
+    std::string error;
+    CHECK(saveGraph(graph, path, error));
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    int accepted = 0;
+    for (size_t size = 0; size < bytes.size(); size += 7) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), (std::streamsize)size);
+        }
+        Graph loaded;
+        error.clear();
+        accepted += loadGraph(loaded, path, error) || error.empty();
+    }
+    CHECK_EQ(accepted, 0);
+    std::remove(path);
+}
@@ -0,0 +1,32 @@
+#include <cstring>
+
+#include "test.h"
+
+namespace subway_test {
+
+std::vector<TestCase> &registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+int failures = 0;
+
+} // namespace subway_test
+
+// Usage: subway_tests [suite]; runs every test without a suite name.
+int main(int argc, char *argv[]) {
+    int run = 0;
+    for (const subway_test::TestCase &test : subway_test::registry()) {
+        if (argc > 1 && std::strcmp(argv[1], test.suite) != 0) continue;
+        int before = subway_test::failures;
+        test.run();
+        std::cout << (subway_test::failures == before ? "[ OK ] " : "[FAIL] ") << test.suite << "." << test.name
+                  << "\n";
+        run++;
+    }
+    if (run == 0) {
+        std::cerr << "No tests in suite " << (argc > 1 ? argv[1] : "") << "\n";
+        return 1;
+    }
+    return subway_test::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#include <string>
+#include <vector>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+// Every key count up to 300, including the powers of two whose slot modulo keeps
+// only the low hash bits, maps the names onto distinct slots.
+TEST(perfect_hash, everySizeIsMinimalAndExact) {
+    int wrong = 0;
+    for (int n = 0; n <= 300; n++) {
+        std::vector<std::string> names;
+        for (int i = 0; i < n; i++) names.push_back("Station " + std::to_string(i));
+        NameIndex index;
+        CHECK(index.build(names));
+        std::vector<char> used(n, 0);
+        for (int i = 0; i < n; i++) {
+            wrong += index.find(names[i]) != i;
+            uint32_t slot = index.hash(names[i]);
+            wrong += slot >= (uint32_t)n || used[slot];
+            if (slot < (uint32_t)n) used[slot] = 1;
+        }
+        wrong += index.find("Station -1") != -1;
+    }
+    CHECK_EQ(wrong, 0);
+}
+
+// An empty key set (built or default-constructed) has no slot for any key.
+TEST(perfect_hash, emptySetHasNoSlot) {
+    PerfectHash built, unbuilt;
+    CHECK(built.build({}));
+    CHECK_EQ(built("Times Sq"), PerfectHash::noSlot);
+    CHECK_EQ(unbuilt("Times Sq"), PerfectHash::noSlot);
+}
+
+TEST(perfect_hash, duplicateNamesAreRejected) {
+    NameIndex index;
+    CHECK(!index.build({"A", "B", "A"}));
+}
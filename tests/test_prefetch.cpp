@@ -0,0 +1,52 @@
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+// A one-way chain whose last station, the last ID, has no outgoing edges, so its
+// edge range starts at view.edges.size().
+Graph deadEndGraph() {
+    Graph graph;
+    graph.addEdge("A", "B", 2, "1");
+    graph.addEdge("B", "C", 3, "1");
+    graph.addEdge("A", "C", 9, "2");
+    graph.addEdge("C", "D", 1, "2");
+    graph.finalize();
+    return graph;
+}
+
+} // namespace
+
+TEST(prefetch, deadEndStationWithPrefetching) {
+    Graph graph = deadEndGraph();
+    const GraphView &view = graph.view(0);
+    int n = (int)graph.stationNames.size();
+    CHECK_EQ(view.offsets[n - 1], (int)view.edges.size());
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            PackedPath plain = findPath(view, s, t, 2);
+            for (int distance : {1, 4, 16}) {
+                PackedPath prefetched = findPath(view, s, t, 2, distance);
+                CHECK_EQ(prefetched.cost, plain.cost);
+                CHECK(prefetched.edges == plain.edges);
+            }
+        }
+    }
+}
+
+TEST(prefetch, deadEndStationInterleaved) {
+    Graph graph = deadEndGraph();
+    const GraphView &view = graph.view(0);
+    int n = (int)graph.stationNames.size();
+    std::vector<std::pair<int, int>> queries;
+    std::vector<int> expected;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            queries.push_back({s, t});
+            expected.push_back(findPath(view, s, t, 2).cost);
+        }
+    }
+    for (int group : {1, 3, 8}) CHECK(interleavedCosts(view, queries, 2, group) == expected);
+}
@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <fstream>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+void writeFeed(const char *path, uint32_t count, const std::vector<FeedEvent> &events) {
+    std::ofstream out(path, std::ios::binary);
+    out.write("EVT1", 4);
+    out.write((const char *)&count, sizeof(count));
+    out.write((const char *)events.data(), (std::streamsize)(events.size() * sizeof(FeedEvent)));
+}
+
+} // namespace
+
+TEST(replay, feedRoundTrip) {
+    std::vector<FeedEvent> events = {{10, FEED_DELAY, {}, 3, 5}, {20, FEED_CLOSE, {}, 4, 0}};
+    writeFeed("replay_test.evt", 2, events);
+    std::vector<FeedEvent> back;
+    std::string error;
+    CHECK(loadEventFeed("replay_test.evt", back, error));
+    CHECK_EQ(back.size(), (size_t)2);
+    CHECK_EQ(back[1].edgeId, (uint32_t)4);
+    std::remove("replay_test.evt");
+}
+
+// A count larger than the file holds is rejected before anything is allocated.
+TEST(replay, oversizedCountIsRejected) {
+    std::vector<FeedEvent> events = {{10, FEED_DELAY, {}, 3, 5}};
+    std::vector<FeedEvent> back;
+    std::string error;
+    writeFeed("replay_test.evt", 0xFFFFFFFFu, events);
+    CHECK(!loadEventFeed("replay_test.evt", back, error));
+    CHECK(error.find("truncated") != std::string::npos);
+    writeFeed("replay_test.evt", 2, events);
+    CHECK(!loadEventFeed("replay_test.evt", back, error));
+    std::remove("replay_test.evt");
+}
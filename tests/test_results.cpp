@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <fstream>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+bool sameBlock(const ResultBlock &a, const ResultBlock &b) {
+    return a.origin == b.origin && a.destination == b.destination && a.cost == b.cost &&
+           a.legOffsets == b.legOffsets && a.legBoard == b.legBoard && a.legAlight == b.legAlight &&
+           a.legLine == b.legLine && a.legStops == b.legStops && a.legCost == b.legCost;
+}
+
+} // namespace
+
+TEST(results, blocksRoundTrip) {
+    Graph graph;
+    generateCityNetwork(graph, 10, 10, 3);
+    const GraphView &view = graph.view(0);
+    int n = (int)graph.stationNames.size();
+    std::vector<ResultBlock> blocks(3);
+    for (int s = 0; s < n; s += 7) {
+        for (int t = 0; t < n; t++) blocks[s % 3].add(s, t, findRoute(view, s, t, 5));
+    }
+    blocks.push_back(ResultBlock()); // an empty block is valid too
+
+    std::string error;
+    ResultWriter writer(2);
+    CHECK(writer.open("results_test.res", error));
+    for (const ResultBlock &block : blocks) writer.submit(block);
+    CHECK(writer.close(error));
+
+    ResultReader reader;
+    CHECK(reader.open("results_test.res", error));
+    ResultBlock back;
+    size_t count = 0;
+    while (reader.next(back, error)) {
+        CHECK(count < blocks.size());
+        if (count < blocks.size()) CHECK(sameBlock(back, blocks[count]));
+        count++;
+    }
+    CHECK(error.empty());
+    CHECK_EQ(count, blocks.size());
+    reader.close();
+    std::remove("results_test.res");
+}
+
+// A block whose declared length runs past the end of the file fails with an
+// error instead of allocating the declared size.
+TEST(results, oversizedBlockIsRejected) {
+    {
+        std::ofstream out("results_test.res", std::ios::binary);
+        uint32_t header[4] = {1, 0, 1, 0xFFFFFFF0u};
+        out.write("RES1", 4);
+        out.write((const char *)header, sizeof(header));
+        out.write("\0\0\0\0", 4);
+    }
+    ResultReader reader;
+    ResultBlock block;
+    std::string error;
+    CHECK(reader.open("results_test.res", error));
+    CHECK(!reader.next(block, error));
+    CHECK(!error.empty());
+    reader.close();
+
+    // The length fits, but the row count claims more values than the payload holds.
+    {
+        std::ofstream out("results_test.res", std::ios::binary);
+        uint32_t header[4] = {0xFFFFFFF0u, 0, 1, 4};
+        out.write("RES1", 4);
+        out.write((const char *)header, sizeof(header));
+        out.write("\0\0\0\0", 4);
+    }
+    CHECK(reader.open("results_test.res", error));
+    CHECK(!reader.next(block, error));
+    CHECK(!error.empty());
+    reader.close();
+    std::remove("results_test.res");
+}
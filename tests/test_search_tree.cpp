@@ -0,0 +1,81 @@
+#include <random>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+// Applies random single-edge changes (increases, decreases, closures and
+// reopenings) and after each one compares the repaired trees of a few origins with
+// fresh ones; returns the number of trees that differ.
+int randomEdits(const GraphView &view, int transferCost, int edits, unsigned seed) {
+    std::mt19937 rng(seed);
+    const int n = (int)view.offsets.size() - 1, m = (int)view.edges.size();
+    std::vector<int> costs(m);
+    for (int e = 0; e < m; e++) costs[e] = view.edges[e].cost;
+    std::vector<SearchTree> trees(4);
+    for (size_t t = 0; t < trees.size(); t++) buildSearchTree(view, (int)(rng() % n), transferCost, trees[t], &costs);
+    int differ = 0;
+    SearchTree fresh;
+    for (int i = 0; i < edits; i++) {
+        int e = (int)(rng() % m);
+        switch (rng() % 4) {
+        case 0: costs[e] = -1; break;
+        case 1: costs[e] = view.edges[e].cost; break;
+        case 2: costs[e] += 1 + (int)(rng() % 5); break;
+        default: costs[e] = std::max(0, costs[e]) / 2; break;
+        }
+        for (SearchTree &tree : trees) {
+            repairSearchTree(view, transferCost, costs, e, tree);
+            buildSearchTree(view, tree.source, transferCost, fresh, &costs);
+            differ += tree.dist != fresh.dist || tree.parentEdge != fresh.parentEdge ||
+                      tree.parentStation != fresh.parentStation || tree.arrivalLine != fresh.arrivalLine;
+        }
+    }
+    return differ;
+}
+
+} // namespace
+
+// Without transfer costs the arrival line never matters; with them a repair that
+// changes a station's arrival line must carry the new penalties down its subtree.
+TEST(search_tree, repairMatchesRebuildOnGrid) {
+    Graph graph;
+    generateCityNetwork(graph, 10, 10, 7);
+    CHECK_EQ(randomEdits(graph.view(0), 0, 1500, 1), 0);
+    CHECK_EQ(randomEdits(graph.view(0), 2, 1500, 2), 0);
+    CHECK_EQ(randomEdits(graph.view(0), 5, 1500, 3), 0);
+}
+
+TEST(search_tree, repairMatchesRebuildOnSample) {
+    Graph graph;
+    buildSampleGraph(graph);
+    CHECK_EQ(randomEdits(graph.view(0), 2, 1500, 4), 0);
+}
+
+// Closing line A moves Y onto line B, which makes D cheaper via Y than on line C
+// although no edge on the way to D changed.
+TEST(search_tree, arrivalLineChangeReachesSubtree) {
+    Graph graph;
+    graph.addBidirectionalEdge("O", "Y", 1, "A");
+    graph.addBidirectionalEdge("O", "Y", 2, "B");
+    graph.addBidirectionalEdge("Y", "D", 1, "B");
+    graph.addBidirectionalEdge("O", "D", 6, "C");
+    graph.finalize();
+    const GraphView &view = graph.view(0);
+    std::vector<int> costs;
+    for (const ViewEdge &edge : view.edges) costs.push_back(edge.cost);
+    SearchTree tree;
+    int o = graph.findStation("O"), d = graph.findStation("D");
+    buildSearchTree(view, o, 5, tree, &costs);
+    CHECK_EQ(tree.dist[d], 6);
+    int closed = -1;
+    for (int e = view.offsets[o]; e < view.offsets[o + 1]; e++) {
+        if (view.edges[e].lineId == graph.findLine("A")) closed = e;
+    }
+    costs[closed] = -1;
+    CHECK(repairSearchTree(view, 5, costs, closed, tree) > 0);
+    CHECK_EQ(tree.dist[d], 3);
+}
@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <fstream>
+
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+Timetable gridTimetable() {
+    Graph graph;
+    generateCityNetwork(graph, 5, 5, 7);
+    return buildTimetable(graph, graph.view(0), 6, 300, 1440, 2);
+}
+
+// Number of queries whose Pareto set disagrees with RAPTOR: the fastest journey
+// must match RAPTOR, and each journey RAPTOR limited to its number of trips.
+int mismatches(const TransferPatterns &patterns) {
+    const Timetable &tt = patterns.timetable;
+    int n = patterns.stationCount(), differ = 0;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            for (int departure : {300, 437, 900}) {
+                std::vector<PatternJourney> result = transferPatternQuery(patterns, s, t, departure);
+                bool same = (result.empty() ? -1 : result.back().arrival) ==
+                            raptorArrival(tt, s, t, departure, patterns.maxTrips);
+                for (size_t j = 0; j < result.size(); j++) {
+                    same = same && raptorArrival(tt, s, t, departure, result[j].trips) == result[j].arrival;
+                    if (j > 0) same = same && result[j].trips > result[j - 1].trips && result[j].arrival < result[j - 1].arrival;
+                }
+                differ += !same;
+            }
+        }
+    }
+    return differ;
+}
+
+bool samePatterns(const TransferPatterns &a, const TransferPatterns &b) {
+    if (a.nodes.size() != b.nodes.size()) return false;
+    for (size_t i = 0; i < a.nodes.size(); i++) {
+        if (a.nodes[i].station != b.nodes[i].station || a.nodes[i].parent != b.nodes[i].parent ||
+            a.nodes[i].walk != b.nodes[i].walk)
+            return false;
+    }
+    return a.nodeOffsets == b.nodeOffsets && a.targetOffsets == b.targetOffsets && a.targetNodes == b.targetNodes;
+}
+
+} // namespace
+
+TEST(transfer_patterns, sampleMatchesRaptor) {
+    Graph graph;
+    buildSampleGraph(graph);
+    TransferPatterns patterns;
+    std::string error;
+    CHECK(buildTransferPatterns(buildTimetable(graph, graph.view(0), 6, 300, 1440, 2), 300, 1440, 8, 2, "", -1,
+                                patterns, error));
+    CHECK_EQ(mismatches(patterns), 0);
+}
+
+TEST(transfer_patterns, gridMatchesRaptor) {
+    TransferPatterns patterns;
+    std::string error;
+    CHECK(buildTransferPatterns(gridTimetable(), 300, 1440, 8, 2, "", -1, patterns, error));
+    CHECK_EQ(mismatches(patterns), 0);
+}
+
+// A build stopped by its origin budget, and one whose last record was cut short,
+// both resume from the progress file to the same patterns as a build in one go.
+TEST(transfer_patterns, progressFileResumes) {
+    const char *path = "transfer_patterns_test.stp";
+    std::remove(path);
+    TransferPatterns whole, resumed;
+    std::string error;
+    CHECK(buildTransferPatterns(gridTimetable(), 300, 1440, 8, 2, "", -1, whole, error));
+
+    int loaded = -1;
+    CHECK(!buildTransferPatterns(gridTimetable(), 300, 1440, 8, 2, path, 10, resumed, error, &loaded));
+    CHECK_EQ(loaded, 0);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out.write("\x05\0\0", 3); // an interrupted record
+    }
+    CHECK(buildTransferPatterns(gridTimetable(), 300, 1440, 8, 2, path, -1, resumed, error, &loaded));
+    CHECK_EQ(loaded, 10);
+    CHECK(samePatterns(resumed, whole));
+
+    // Everything is in the file now: nothing is recomputed.
+    CHECK(buildTransferPatterns(gridTimetable(), 300, 1440, 8, 2, path, 0, resumed, error, &loaded));
+    CHECK_EQ(loaded, whole.stationCount());
+    CHECK(samePatterns(resumed, whole));
+
+    // A different window does not match the file's fingerprint.
+    CHECK(!buildTransferPatterns(gridTimetable(), 300, 1200, 8, 2, path, -1, resumed, error));
+    CHECK(error.find("different timetable") != std::string::npos);
+    std::remove(path);
+}
@@ -0,0 +1,60 @@
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+// Number of station pairs where the transit node answer differs from line-graph
+// Dijkstra; 'far' receives how many were answered from the table.
+int mismatches(const TransitNodes &tnr, int n, int &far) {
+    int differ = 0;
+    far = 0;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            bool local = false;
+            differ += transitNodeCost(tnr, s, t, &local) != lineGraphCost(tnr.lineGraph, s, t);
+            far += !local;
+        }
+    }
+    return differ;
+}
+
+} // namespace
+
+// Staying on line B from O to D costs 3; the station-level label at Y prefers line A.
+TEST(transit_nodes, lineGraphCostStaysOnLine) {
+    Graph graph;
+    graph.addBidirectionalEdge("O", "Y", 1, "A");
+    graph.addBidirectionalEdge("O", "Y", 2, "B");
+    graph.addBidirectionalEdge("Y", "D", 1, "B");
+    graph.addBidirectionalEdge("O", "D", 6, "C");
+    graph.addEdge("D", "Z", 1, "C");
+    graph.finalize();
+    TransitNodes tnr = buildTransitNodes(graph.view(0), 5, 1, 10, 1);
+    int o = graph.findStation("O"), d = graph.findStation("D"), z = graph.findStation("Z");
+    CHECK_EQ(lineGraphCost(tnr.lineGraph, o, d), 3);
+    CHECK_EQ(lineGraphCost(tnr.lineGraph, o, o), 0);
+    CHECK_EQ(lineGraphCost(tnr.lineGraph, z, o), -1);
+    CHECK_EQ(transitNodeCost(tnr, o, d), 3);
+    CHECK_EQ(transitNodeCost(tnr, z, o), -1);
+}
+
+TEST(transit_nodes, sampleMatchesLineGraph) {
+    Graph graph;
+    buildSampleGraph(graph);
+    int n = (int)graph.stationNames.size(), far = 0;
+    for (int hubs : {1, 4, 8}) {
+        TransitNodes tnr = buildTransitNodes(graph.view(0), 2, hubs, 50, 2);
+        CHECK_EQ(mismatches(tnr, n, far), 0);
+    }
+}
+
+TEST(transit_nodes, gridMatchesLineGraph) {
+    Graph graph;
+    generateCityNetwork(graph, 12, 12, 7);
+    int n = (int)graph.stationNames.size(), far = 0;
+    TransitNodes tnr = buildTransitNodes(graph.view(0), 5, 16, 100, 2);
+    CHECK_EQ(mismatches(tnr, n, far), 0);
+    CHECK(far > 0); // some queries exercise the table
+}
@@ -0,0 +1,60 @@
+#include "subway/subway.h"
+#include "test.h"
+
+using namespace subway;
+
+namespace {
+
+// Compares earliest-arrival queries for every pair at a few departures, and one-hour
+// profiles from every origin to every other station, with RAPTOR.
+void checkAgainstRaptor(const TripBased &tb) {
+    const Timetable &tt = tb.timetable;
+    TripBasedQuery query(tb);
+    int n = (int)tt.stationStopOffsets.size() - 1;
+    int arrivals = 0, profiles = 0;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            for (int departure : {290, 317, 480, 1430}) {
+                arrivals += query.earliestArrival(s, t, departure) != raptorArrival(tt, s, t, departure);
+            }
+            for (const ProfileEntry &e : query.profile(s, t, 420, 480)) {
+                profiles += e.departure < 420 || e.departure > 480 ||
+                            raptorArrival(tt, s, t, e.departure, e.transfers + 1) != e.arrival;
+            }
+        }
+    }
+    CHECK_EQ(arrivals, 0);
+    CHECK_EQ(profiles, 0);
+}
+
+} // namespace
+
+TEST(trip_based, sampleMatchesRaptor) {
+    Graph graph;
+    buildSampleGraph(graph);
+    checkAgainstRaptor(buildTripBased(buildTimetable(graph, graph.view(0), 6, 300, 1440, 2), 2));
+}
+
+TEST(trip_based, gridMatchesRaptor) {
+    Graph graph;
+    generateCityNetwork(graph, 5, 5, 7);
+    checkAgainstRaptor(buildTripBased(buildTimetable(graph, graph.view(0), 7, 300, 1440, 3), 2));
+}
+
+// One line A-B-C every 10 minutes: a query just after a departure waits for the
+// next trip, and a query after the last trip finds none.
+TEST(trip_based, singleLine) {
+    Graph graph;
+    graph.addBidirectionalEdge("A", "B", 4, "1");
+    graph.addBidirectionalEdge("B", "C", 5, "1");
+    graph.finalize();
+    TripBased tb = buildTripBased(buildTimetable(graph, graph.view(0), 10, 300, 1440, 2), 1);
+    TripBasedQuery query(tb);
+    int a = graph.findStation("A"), c = graph.findStation("C");
+    int first = query.earliestArrival(a, c, 0);
+    CHECK(first >= 309);
+    CHECK_EQ(query.earliestArrival(a, c, first - 9), first);
+    CHECK_EQ(query.earliestArrival(a, c, first - 8), first + 10);
+    CHECK_EQ(query.earliestArrival(a, c, 1440), -1);
+    CHECK_EQ(query.earliestArrival(a, a, 500), 500);
+}